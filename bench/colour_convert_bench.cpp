@@ -0,0 +1,75 @@
+#include "core.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "video/colour_convert.hpp"
+
+/**
+    Times converting a frame of colour indices to RGBA on each path the
+    CPU supports, and checks every path agrees with the scalar one.
+
+    Build with `cmake --build <build_directory> --target ColourConvertBenchmark`
+**/
+
+constexpr u32 FRAMES = 20000;
+
+auto main() -> int
+{
+    std::mt19937 rng(0x5EED);
+    std::uniform_int_distribution<int> colour(0, 11);
+
+    std::array<Colour::GBColour, COLOUR_BUFFER_SIZE> indices;
+    for(Colour::GBColour& index : indices)
+    {
+        index = static_cast<Colour::GBColour>(colour(rng));
+    }
+
+    Colour::Palette palette {};
+    for(u8 i = 0; i < palette.size(); ++i)
+    {
+        palette[i] = Colour::toPixel(Colour::GREEN_SHADES[(i * 3 + i / 4) % 4]);
+    }
+
+    std::vector<u8> expected(FRAME_BUFFER_SIZE);
+    Colour::toRGBA(indices.data(), expected.data(), COLOUR_BUFFER_SIZE, palette, Colour::ConvertPath::Scalar);
+
+    const std::array<std::pair<Colour::ConvertPath, const char*>, 3> paths = {{
+        { Colour::ConvertPath::Scalar, "Scalar" },
+        { Colour::ConvertPath::SSSE3,  "SSSE3"  },
+        { Colour::ConvertPath::AVX2,   "AVX2"   }
+    }};
+
+    double scalarTime = 0;
+    for(const auto& [path, name] : paths)
+    {
+        if(!Colour::isConvertPathSupported(path))
+        {
+            std::cout << std::setw(8) << name << ": not supported" << std::endl;
+            continue;
+        }
+
+        std::vector<u8> rgba(FRAME_BUFFER_SIZE);
+
+        auto start = std::chrono::steady_clock::now();
+        for(u32 frame = 0; frame < FRAMES; ++frame)
+        {
+            Colour::toRGBA(indices.data(), rgba.data(), COLOUR_BUFFER_SIZE, palette, path);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double time = std::chrono::duration<double, std::micro>(end - start).count() / FRAMES;
+        if(path == Colour::ConvertPath::Scalar)
+        {
+            scalarTime = time;
+        }
+
+        std::cout << std::setw(8) << name << ": " << std::fixed << std::setprecision(2) << time << "us/frame, "
+                  << scalarTime / time << "x scalar" << (rgba == expected ? "" : " (MISMATCH)") << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "core.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "video/frame_hash.hpp"
+
+/**
+    Times hashing a frame of colour indices on each path the CPU
+    supports, and checks every path agrees with the scalar one.
+
+    Build with `cmake --build <build_directory> --target FrameHashBenchmark`
+**/
+
+constexpr u32 FRAMES = 20000;
+
+auto main() -> int
+{
+    std::mt19937 rng(0x5EED);
+    std::uniform_int_distribution<int> colour(0, 11);
+
+    std::vector<u8> indices(COLOUR_BUFFER_SIZE);
+    for(u8& index : indices)
+    {
+        index = static_cast<u8>(colour(rng));
+    }
+
+    u64 expected = FrameHash::hash(indices.data(), indices.size(), 0, FrameHash::HashPath::Scalar);
+
+    const std::array<std::pair<FrameHash::HashPath, const char*>, 3> paths = {{
+        { FrameHash::HashPath::Scalar, "Scalar" },
+        { FrameHash::HashPath::SSE2,   "SSE2"   },
+        { FrameHash::HashPath::AVX2,   "AVX2"   }
+    }};
+
+    double scalarTime = 0;
+    for(const auto& [path, name] : paths)
+    {
+        if(!FrameHash::isHashPathSupported(path))
+        {
+            std::cout << std::setw(8) << name << ": not supported" << std::endl;
+            continue;
+        }
+
+        // Each frame is seeded with the last hash, so none of them can be skipped
+        u64 hash = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for(u32 frame = 0; frame < FRAMES; ++frame)
+        {
+            hash = FrameHash::hash(indices.data(), indices.size(), hash, path);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double time = std::chrono::duration<double, std::micro>(end - start).count() / FRAMES;
+        if(path == FrameHash::HashPath::Scalar)
+        {
+            scalarTime = time;
+        }
+
+        bool matches = FrameHash::hash(indices.data(), indices.size(), 0, path) == expected;
+        std::cout << std::setw(8) << name << ": " << std::fixed << std::setprecision(2) << time << "us/frame, "
+                  << scalarTime / time << "x scalar" << (matches ? "" : " (MISMATCH)") << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "core.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "video/scaler.hpp"
+
+/**
+    Times scaling a frame up with each filter at each rendering scale,
+    and checks nearest neighbour against simply repeating each pixel.
+
+    The frame is made of runs of the four shades, so the filters find
+    edges to work on the way they would in a game.
+
+    Build with `cmake --build <build_directory> --target ScalerBenchmark`
+**/
+
+constexpr u32 FRAMES    = 500;
+constexpr u8  MAX_SCALE = 6;
+
+auto main() -> int
+{
+    std::mt19937 rng(0x5EED);
+    std::uniform_int_distribution<int> shade(0, 3);
+    std::uniform_int_distribution<int> run(1, 12);
+
+    const std::array<u32, 4> shades = { 0xFF0FBC9B, 0xFF0FAC8B, 0xFF306230, 0xFF0F380F };
+
+    std::vector<u32> frame(COLOUR_BUFFER_SIZE);
+    for(u32 pixel = 0; pixel < frame.size(); )
+    {
+        u32 colour = shades[shade(rng)];
+        for(int length = run(rng); length > 0 && pixel < frame.size(); --length)
+        {
+            frame[pixel++] = colour;
+        }
+    }
+
+    const std::array<std::pair<ScaleFilter, const char*>, 4> filters = {{
+        { ScaleFilter::Nearest, "Nearest" },
+        { ScaleFilter::Scale2x, "Scale2x" },
+        { ScaleFilter::Scale3x, "Scale3x" },
+        { ScaleFilter::XBR,     "xBR"     }
+    }};
+
+    Scaler scaler;
+    for(const auto& [filter, name] : filters)
+    {
+        for(u8 scale = 1; scale <= MAX_SCALE; ++scale)
+        {
+            // Only time the scales the filter is actually used at
+            if(scale % Scaler::getFilterScale(filter) != 0)
+            {
+                continue;
+            }
+
+            scaler.setFilter(filter, scale);
+            std::vector<u32> scaled(COLOUR_BUFFER_SIZE * scale * scale);
+
+            // Once first, so the buffers are paged in before the clock starts
+            scaler.scale(reinterpret_cast<const u8*>(frame.data()), scaled.data());
+
+            auto start = std::chrono::steady_clock::now();
+            for(u32 i = 0; i < FRAMES; ++i)
+            {
+                scaler.scale(reinterpret_cast<const u8*>(frame.data()), scaled.data());
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            bool matches = true;
+            if(filter == ScaleFilter::Nearest)
+            {
+                const u32 width = SCREEN_WIDTH * scale;
+                for(u32 pixel = 0; pixel < scaled.size(); ++pixel)
+                {
+                    matches &= scaled[pixel] == frame[(pixel / width / scale) * SCREEN_WIDTH + (pixel % width) / scale];
+                }
+            }
+
+            double time = std::chrono::duration<double, std::micro>(end - start).count() / FRAMES;
+            std::cout << std::setw(8) << name << " x" << static_cast<u32>(scale) << ": "
+                      << std::fixed << std::setprecision(2) << time << "us/frame" << (matches ? "" : " (MISMATCH)") << std::endl;
+        }
+    }
+
+    return 0;
+}
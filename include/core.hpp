@@ -79,8 +79,22 @@ constexpr u8  STAT_VBLANK_BIT   = 4;
 constexpr u8  STAT_OAM_BIT      = 5;
 constexpr u8  STAT_LYC_BIT      = 6;
 
+// Only the interrupt selects can be written, the rest of STAT comes from the PPU. Bit 7 always reads as 1
+constexpr u8  STAT_WRITABLE_MASK = 0b01111000;
+constexpr u8  STAT_UNUSED_BITS   = 0b10000000;
+
+constexpr u8  LCD_ENABLE_BIT    = 7;
+
 //Graphics Data
 constexpr u8  DMA_TRANSFER_SIZE     = 0xA0;
+constexpr u8  CYCLES_PER_DMA_BYTE   = 4;
+
+// HDMA copies 16 bytes at a time, taking 32 cycles of single speed time for each
+constexpr u8  HDMA_BLOCK_SIZE       = 0x10;
+constexpr u8  CYCLES_PER_HDMA_BLOCK = 32;
+
+// Each palette ram holds 8 palettes of 4 colours, 2 bytes (RGB555) per colour
+constexpr u8  CGB_PALETTE_RAM_SIZE  = 64;
 
 constexpr u16 TILE_DATA_LOW         = 0x8800;
 constexpr u16 TILE_DATA_HIGH        = 0x8000;
@@ -97,12 +111,17 @@ constexpr u8  TILE_WIDTH            = 8;
 constexpr u8  TILE_HEIGHT           = 8;
 constexpr u8  TILES_PER_LINE        = 32;
 constexpr u8  BYTES_PER_TILE        = 16;
+constexpr u16 TILE_COUNT            = 384;
 
 constexpr u8  BYTES_PER_SPRITE      = 4;
 constexpr u8  SPRITE_WIDTH          = 8;
 constexpr u8  SPRITE_HEIGHT         = 8;
 constexpr u8  SPRITE_X_OFFSET       = 8;
 constexpr u8  SPRITE_Y_OFFSET       = 16;
+constexpr u8  SPRITE_COUNT          = 40;
+constexpr u8  SPRITES_PER_LINE      = 10;
+
+constexpr u8  WINDOW_X_OFFSET       = 7;
 
 constexpr u8  SCREEN_WIDTH          = 160;
 constexpr u8  SCREEN_HEIGHT         = 144;
@@ -112,9 +131,11 @@ constexpr u32 COLOUR_BUFFER_SIZE    = SCREEN_WIDTH * SCREEN_HEIGHT;
 constexpr u32 FRAME_BUFFER_SIZE     = COLOUR_BUFFER_SIZE * 4;
 
 //Rendering Defaults
-constexpr float TARGET_SPEED_MULTIPLIER     = 100.0f / 60.0f; // 60fps in percentage, same as '/ 60.0f * 100.0f'
-constexpr float DEFAULT_TITLE_UPDATE_RATE   = 0.5;
-constexpr u32   DEFAULT_RENDERING_SCALE     = 4;
+constexpr float DEFAULT_TITLE_UPDATE_RATE    = 0.5;
+constexpr float DEFAULT_FRONTEND_UPDATE_RATE = 1.0f / 240.0f;
+constexpr u32   PACING_REPORT_INTERVAL       = 600;
+constexpr float DEBUGGER_PAUSED_POLL_RATE    = 1.0f / 240.0f;
+constexpr u32   DEFAULT_RENDERING_SCALE      = 4;
 
 //Clock and Timers
 constexpr u32 CLOCK_SPEED       = 4194304;
@@ -124,8 +145,11 @@ constexpr u32 TIMER_SPEED_01    = 16;
 constexpr u32 TIMER_SPEED_10    = 64;
 constexpr u32 TIMER_SPEED_11    = 256;
 
-// Temp drawing before implementing pixel FIFO
-// HBLANK and DRAWING clocks might be different with FIFO
+// The CPU stops for a while as it switches between single and double speed
+constexpr u16 CYCLES_PER_SPEED_SWITCH = 8200;
+
+// Mode lengths when drawing a line at a time. The pixel FIFO makes
+// TRANSFER as long as it takes, and HBLANK the rest of the line
 constexpr u16 CYCLES_PER_HBLANK   = 204;
 constexpr u16 CYCLES_PER_VBLANK   = 4560;
 constexpr u16 CYCLES_PER_OAM_SCAN = 80;
@@ -137,6 +161,11 @@ constexpr u16 CYCLES_PER_LINE   = CYCLES_PER_HBLANK
 
 constexpr u32 CYCLES_PER_FRAME  = CYCLES_PER_LINE * VBLANK_HEIGHT;
 
+// The DMG's real frame rate, a little under 60
+constexpr double FRAME_RATE     = static_cast<double>(CLOCK_SPEED) / CYCLES_PER_FRAME; // 59.7275
+
+constexpr float TARGET_SPEED_MULTIPLIER = 100.0f / FRAME_RATE; // Full speed fps in percentage, same as '/ FRAME_RATE * 100.0f'
+
 //Joypad Info
 /**
     https://gbdev.io/pandocs/Joypad_Input.html
@@ -152,6 +181,7 @@ constexpr u8  P15_INPUT_BIT     = 5; //Action buttons    (0=Select)
 //Cartridge Header
 constexpr u16 CART_TITLE                = 0x134;
 constexpr u16 CART_TITLE_SIZE           = 16;
+constexpr u16 CART_CGB_FLAG             = 0x0143; // Bit 7 is set for carts made for the Gameboy Color
 constexpr u16 CART_TYPE                 = 0x0147;
 constexpr u16 CART_RAM_SIZE             = 0x0149;
 constexpr u16 CART_VERSION_NUMBER       = 0x014C;
@@ -166,6 +196,18 @@ constexpr u32 RAM_BANK_SIZE             = 0x2000;
 constexpr u32 RAM_BANK_OFFSET           = 0xA000;
 constexpr u32 INTERNAL_RAM_SIZE         = 0x2000;
 
+// The Gameboy Color banks VRAM, and the upper half of internal ram
+constexpr u32 VRAM_BANK_SIZE            = 0x2000;
+constexpr u32 VRAM_BANK_COUNT           = 2;
+constexpr u32 WRAM_BANK_SIZE            = 0x1000;
+constexpr u32 WRAM_BANK_COUNT           = 8;
+
+constexpr u16 PAGE_SIZE                 = 0x0100;
+constexpr u16 PAGE_COUNT                = 0x0100;
+
+constexpr u16 DIRTY_VRAM_BLOCK_SIZE     = 0x0010;
+constexpr u16 DIRTY_PAGE_SIZE           = PAGE_SIZE;
+
 constexpr u16 ROM_START_ADDR            = 0x0000;
 constexpr u16 ROM_END_ADDR              = 0x8000;
 
@@ -178,6 +220,8 @@ constexpr u16 RAM_BANK_END_ADDR         = 0xC000;
 constexpr u16 INTERNAL_RAM_START_ADDR   = 0xC000;
 constexpr u16 INTERNAL_RAM_END_ADDR     = 0xE000;
 
+constexpr u16 WRAM_BANK_START_ADDR      = 0xD000;
+
 constexpr u16 ECHO_RAM_START_ADDR       = 0xE000;
 constexpr u16 ECHO_RAM_END_ADDR         = 0xFE00;
 
@@ -275,8 +319,27 @@ constexpr u16 WX_REGISTER               = 0xFF4B;
 
 // 0xFF4C UNUSED
 
+constexpr u16 SPEED_REGISTER            = 0xFF4D; // KEY1
+
+// 0xFF4E UNUSED
+
+constexpr u16 VRAM_BANK_REGISTER        = 0xFF4F; // VBK
+
 constexpr u16 BOOT_REGISTER             = 0xFF50;
 
+constexpr u16 HDMA_SOURCE_HI_REGISTER   = 0xFF51;
+constexpr u16 HDMA_SOURCE_LO_REGISTER   = 0xFF52;
+constexpr u16 HDMA_DEST_HI_REGISTER     = 0xFF53;
+constexpr u16 HDMA_DEST_LO_REGISTER     = 0xFF54;
+constexpr u16 HDMA_CONTROL_REGISTER     = 0xFF55;
+
+constexpr u16 BG_PALETTE_INDEX_REGISTER  = 0xFF68; // BCPS
+constexpr u16 BG_PALETTE_DATA_REGISTER   = 0xFF69; // BCPD
+constexpr u16 OBJ_PALETTE_INDEX_REGISTER = 0xFF6A; // OCPS
+constexpr u16 OBJ_PALETTE_DATA_REGISTER  = 0xFF6B; // OCPD
+
+constexpr u16 WRAM_BANK_REGISTER        = 0xFF70; // SVBK
+
 constexpr u16 IF_REGISTER               = 0xFF0F;
 constexpr u16 IE_REGISTER               = 0xFFFF;
 
@@ -287,3 +350,12 @@ constexpr u16 DE_RESET = 0x00D8;
 constexpr u16 HL_RESET = 0x014D;
 constexpr u16 SP_RESET = 0xFFFE;
 constexpr u16 PC_RESET = 0x0100;
+
+// A Gameboy Color boot rom leaves 0x11 in A, which is how games tell they can use colour
+constexpr u16 AF_RESET_CGB = 0x1180;
+constexpr u16 BC_RESET_CGB = 0x0000;
+constexpr u16 DE_RESET_CGB = 0xFF56;
+constexpr u16 HL_RESET_CGB = 0x000D;
+
+constexpr u8  LCDC_RESET = 0x91;
+constexpr u8  BGP_RESET  = 0xFC;
@@ -64,6 +64,11 @@ auto MBC::getCartTitle(const std::vector<u8>& data) -> const std::string
     return title;
 }
 
+auto MBC::isCartCGB(const std::vector<u8>& data) -> bool
+{
+    return data.size() > CART_CGB_FLAG && bit_functions::get_bit(data[CART_CGB_FLAG], 7);
+}
+
 auto MBC::getCartRamSize(const std::vector<u8>& data) -> u32
 {
     switch(data[CART_RAM_SIZE])
@@ -125,13 +130,15 @@ MBC::MBC(std::vector<u8>&& rom, std::vector<u8>&& ram)
     {
         m_Ram = std::vector<u8>(ramSize, 0);
     }
-    else if(ram.size() != ramSize)
+    else if(ram.size() < ramSize)
     {
         ERROR("Invalid RAM size. Data may be corrupted!");
     }
     else
     {
         DEBUG("Read RAM from disk.");
+        m_SaveExtra.assign(ram.begin() + ramSize, ram.end());
+        ram.resize(ramSize);
         m_Ram = std::move(ram);
     }
 }
@@ -142,3 +149,8 @@ auto MBC::getRam() -> const std::vector<u8>&
 {
     return m_Ram;
 }
+
+auto MBC::getSaveData() const -> std::vector<u8>
+{
+    return m_Ram;
+}
@@ -61,6 +61,14 @@ class MBC
          */
         [[nodiscard]] static auto getCartTitle(const std::vector<u8>& data) -> const std::string;
 
+        /**
+         * @brief Checks if a cart was made for the Gameboy Color,
+         * either only for it or as an enhanced DMG game
+         * 
+         * @param data The rom's data
+         */
+        [[nodiscard]] static auto isCartCGB(const std::vector<u8>& data) -> bool;
+
         /**
          * @brief Get the amount of ram a cart supports
          * 
@@ -98,15 +106,41 @@ class MBC
          * 
          * @param address The address to write to
          * @param val The value to write
+         * @return If the rom bank mapped to 0x4000-0x7FFF changed
+         */
+        virtual auto write(u16 address, u8 val) -> bool = 0;
+
+        /**
+         * @brief Resolves an address to the memory backing it, for block copies
+         * 
+         * @param address The address to resolve
+         * @return A pointer to the byte at that address, or nullptr if the
+         * address isn't backed by plain memory
          */
-        virtual void write(u16 address, u8 val) = 0;
+        [[nodiscard]] virtual auto resolve(u16 address) const -> const u8* = 0;
+
+        /**
+         * @brief Gets the rom bank currently mapped to 0x4000-0x7FFF
+         * 
+         */
+        [[nodiscard]] virtual auto getRomBank() const -> u16 = 0;
 
         /**
          * @brief Gets the ram of the cartridge (mainly for saving)
          * 
          */
         [[nodiscard]] auto getRam() -> const std::vector<u8>&;
+
+        /**
+         * @brief Gets everything that should be written to the save file,
+         * the ram followed by any extra state the MBC keeps (i.e. an RTC)
+         * 
+         */
+        [[nodiscard]] virtual auto getSaveData() const -> std::vector<u8>;
     protected:
         std::vector<u8> m_Rom;
         std::vector<u8> m_Ram;
+
+        // Anything in the save file past the end of the ram
+        std::vector<u8> m_SaveExtra;
 };
@@ -42,8 +42,10 @@ auto MBC1::read(u16 address) const -> u8
     }
 }
 
-void MBC1::write(u16 address, u8 val)
+auto MBC1::write(u16 address, u8 val) -> bool
 {
+    u8 bank = m_RomBankNumber;
+
     switch(address & 0xE000)
     {
         case 0x0000: //RAM Enable
@@ -79,4 +81,32 @@ void MBC1::write(u16 address, u8 val)
                 }
             }
     }
+
+    return m_RomBankNumber != bank;
+}
+
+auto MBC1::resolve(u16 address) const -> const u8*
+{
+    u32 offset;
+    switch(address & 0xE000)
+    {
+        case 0x0000:
+        case 0x2000:
+            offset = address;
+            return (offset < m_Rom.size()) ? &m_Rom[offset] : nullptr;
+        case 0x4000:
+        case 0x6000:
+            offset = (address - ROM_BANK_OFFSET) + ROM_BANK_SIZE * m_RomBankNumber;
+            return (offset < m_Rom.size()) ? &m_Rom[offset] : nullptr;
+        case 0xA000:
+            offset = (address - RAM_BANK_OFFSET) + RAM_BANK_SIZE * m_RamBankNumber;
+            return (offset < m_Ram.size()) ? &m_Ram[offset] : nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+auto MBC1::getRomBank() const -> u16
+{
+    return m_RomBankNumber;
 }
@@ -23,8 +23,24 @@ class MBC1 final : public MBC
          * 
          * @param address The address to write to
          * @param val The value to write
+         * @return If the rom bank mapped to 0x4000-0x7FFF changed
          */
-        virtual void write(u16 address, u8 val) final;
+        virtual auto write(u16 address, u8 val) -> bool final;
+
+        /**
+         * @brief Resolves an address to the memory backing it, for block copies
+         * 
+         * @param address The address to resolve
+         * @return A pointer to the byte at that address, or nullptr if the
+         * address isn't backed by plain memory
+         */
+        [[nodiscard]] virtual auto resolve(u16 address) const -> const u8* final;
+
+        /**
+         * @brief Gets the rom bank currently mapped to 0x4000-0x7FFF
+         * 
+         */
+        [[nodiscard]] virtual auto getRomBank() const -> u16 final;
 
     private:
         u8 m_RomBankNumber;
@@ -2,10 +2,18 @@
 
 #include "mbc3.hpp"
 
-MBC3::MBC3(std::vector<u8>&& rom, std::vector<u8>&& ram)
+MBC3::MBC3(std::vector<u8>&& rom, std::vector<u8>&& ram, const u64& cycles, RTCMode mode)
     : MBC(std::move(rom), std::move(ram)),
       m_RomBankNumber(1), m_RamBankNumber(0),
-      m_RamEnabled(false), m_RTCEnabled(false) {}
+      m_RamEnabled(false), m_RTCEnabled(false), m_RTCRegister(0)
+{
+    Cart::Type type = getCartType(m_Rom);
+    if(type == Cart::Type::MBC3_TIMER_BATTERY || type == Cart::Type::MBC3_TIMER_RAM_BATTERY_2)
+    {
+        m_RTC.emplace(cycles, mode);
+        m_RTC->load(m_SaveExtra);
+    }
+}
 
 MBC3::~MBC3() = default;
 
@@ -20,6 +28,10 @@ auto MBC3::read(u16 address) const -> u8
         case 0x6000:
             return m_Rom[(address - ROM_BANK_OFFSET) + ROM_BANK_SIZE * m_RomBankNumber];
         case 0xA000:
+            if(m_RTCEnabled)
+            {
+                return m_RTC ? m_RTC->read(m_RTCRegister) : UINT8_MAX;
+            }
             return m_Ram[(address - RAM_BANK_OFFSET) + RAM_BANK_SIZE * m_RamBankNumber];
         default:
             WARN("Trying to read from address 0x" << std::hex << std::setw(4) << std::setfill('0') << address << '!');
@@ -27,8 +39,10 @@ auto MBC3::read(u16 address) const -> u8
     }
 }
 
-void MBC3::write(u16 address, u8 val)
+auto MBC3::write(u16 address, u8 val) -> bool
 {
+    u8 bank = m_RomBankNumber;
+
     switch(address & 0xE000)
     {
         case 0x0000: // RAM Enable
@@ -45,20 +59,21 @@ void MBC3::write(u16 address, u8 val)
                 m_RamBankNumber = val;
                 m_RTCEnabled = false;
             }
-            else if(0x80 <= val && val <= 0x0C)
+            else if(0x08 <= val && val <= 0x0C)
             {
-                m_RTCEnabled = true;
-                // TODO: RTC
+                m_RTCEnabled  = true;
+                m_RTCRegister = val;
             }
             break;
-        case 0x6000: // TODO: RTC
+        case 0x6000: // Latch Clock Data
+            if(m_RTC) m_RTC->latch(val);
             break;
         case 0xA000:
-            if(!m_RamEnabled) return;
+            if(!m_RamEnabled) break;
 
             if(m_RTCEnabled)
             {
-                // TODO: RTC
+                if(m_RTC) m_RTC->write(m_RTCRegister, val);
             }
             else
             {
@@ -69,4 +84,47 @@ void MBC3::write(u16 address, u8 val)
             WARN("Trying to write 0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(val)
                   << " to address 0x" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(val) << '!');
     }
+
+    return m_RomBankNumber != bank;
+}
+
+auto MBC3::resolve(u16 address) const -> const u8*
+{
+    u32 offset;
+    switch(address & 0xE000)
+    {
+        case 0x0000:
+        case 0x2000:
+            offset = address;
+            return (offset < m_Rom.size()) ? &m_Rom[offset] : nullptr;
+        case 0x4000:
+        case 0x6000:
+            offset = (address - ROM_BANK_OFFSET) + ROM_BANK_SIZE * m_RomBankNumber;
+            return (offset < m_Rom.size()) ? &m_Rom[offset] : nullptr;
+        case 0xA000:
+            if(m_RTCEnabled) return nullptr;
+
+            offset = (address - RAM_BANK_OFFSET) + RAM_BANK_SIZE * m_RamBankNumber;
+            return (offset < m_Ram.size()) ? &m_Ram[offset] : nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+auto MBC3::getRomBank() const -> u16
+{
+    return m_RomBankNumber;
+}
+
+auto MBC3::getSaveData() const -> std::vector<u8>
+{
+    std::vector<u8> data = m_Ram;
+
+    if(m_RTC)
+    {
+        std::vector<u8> rtc = m_RTC->save();
+        data.insert(data.end(), rtc.begin(), rtc.end());
+    }
+
+    return data;
 }
@@ -3,11 +3,14 @@
 #include "core.hpp"
 
 #include "mbc.hpp"
+#include "rtc.hpp"
+
+#include <optional>
 
 class MBC3 final : public MBC
 {
     public:
-        MBC3(std::vector<u8>&& rom, std::vector<u8>&& ram);
+        MBC3(std::vector<u8>&& rom, std::vector<u8>&& ram, const u64& cycles, RTCMode mode);
         ~MBC3() final;
         
         /**
@@ -23,12 +26,37 @@ class MBC3 final : public MBC
          * 
          * @param address The address to write to
          * @param val The value to write
+         * @return If the rom bank mapped to 0x4000-0x7FFF changed
+         */
+        virtual auto write(u16 address, u8 val) -> bool final;
+
+        /**
+         * @brief Resolves an address to the memory backing it, for block copies
+         * 
+         * @param address The address to resolve
+         * @return A pointer to the byte at that address, or nullptr if the
+         * address isn't backed by plain memory
+         */
+        [[nodiscard]] virtual auto resolve(u16 address) const -> const u8* final;
+
+        /**
+         * @brief Gets the rom bank currently mapped to 0x4000-0x7FFF
+         * 
          */
-        virtual void write(u16 address, u8 val) final;
+        [[nodiscard]] virtual auto getRomBank() const -> u16 final;
+
+        /**
+         * @brief Gets the ram followed by the RTC state, if the cart has one
+         * 
+         */
+        [[nodiscard]] virtual auto getSaveData() const -> std::vector<u8> final;
     private:
         u8 m_RomBankNumber;
         u8 m_RamBankNumber;
 
         bool m_RamEnabled;
         bool m_RTCEnabled;
+        u8   m_RTCRegister;
+
+        std::optional<RTC> m_RTC;
 };
@@ -11,7 +11,20 @@ RomOnly::~RomOnly() = default;
     return m_Rom[address];
 }
 
-void RomOnly::write([[maybe_unused]] u16 address, [[maybe_unused]] u8 val)
+auto RomOnly::write([[maybe_unused]] u16 address, [[maybe_unused]] u8 val) -> bool
 {
     // nop
+    return false;
+}
+
+[[nodiscard]] auto RomOnly::resolve(u16 address) const -> const u8*
+{
+    if(address >= m_Rom.size()) return nullptr;
+
+    return &m_Rom[address];
+}
+
+[[nodiscard]] auto RomOnly::getRomBank() const -> u16
+{
+    return 1;
 }
@@ -0,0 +1,213 @@
+#include "core.hpp"
+
+#include "rtc.hpp"
+
+#include <chrono>
+
+constexpr u64 SECONDS_PER_MINUTE = 60;
+constexpr u64 SECONDS_PER_HOUR   = 60 * SECONDS_PER_MINUTE;
+constexpr u64 SECONDS_PER_DAY    = 24 * SECONDS_PER_HOUR;
+constexpr u64 RTC_MAX_DAYS       = 512;
+
+constexpr u8  RTC_DAY_HIGH_BIT   = 0;
+constexpr u8  RTC_HALT_BIT       = 6;
+constexpr u8  RTC_CARRY_BIT      = 7;
+
+constexpr u32 RTC_SAVE_REGISTER_SIZE = 4;
+constexpr u32 RTC_SAVE_SIZE          = 48;
+constexpr u32 RTC_SAVE_SIZE_32BIT    = 44;
+
+RTC::RTC(const u64& cycles, RTCMode mode)
+    : m_Cycles(cycles), m_Mode(mode), m_Base(0), m_Reference(now()),
+      m_Halted(false), m_Carry(false), m_Latched({}), m_LatchValue(UINT8_MAX) {}
+
+void RTC::latch(u8 val)
+{
+    if(m_LatchValue == 0x00 && val == 0x01)
+    {
+        m_Latched = getRegisters();
+    }
+
+    m_LatchValue = val;
+}
+
+auto RTC::read(u8 reg) const -> u8
+{
+    return m_Latched[reg - 0x08];
+}
+
+void RTC::write(u8 reg, u8 val)
+{
+    rebase();
+
+    std::array<u8, 5> registers = getRegisters();
+    registers[reg - 0x08] = val;
+
+    m_Base  = toSeconds(registers);
+    m_Carry = bit_functions::get_bit(registers[DaysHigh], RTC_CARRY_BIT);
+
+    // Writing the seconds resets the sub-second counter, as does resuming from a halt
+    bool halted = bit_functions::get_bit(registers[DaysHigh], RTC_HALT_BIT);
+    if(reg - 0x08 == Seconds || (m_Halted && !halted))
+    {
+        m_Reference = now();
+    }
+
+    m_Halted = halted;
+}
+
+void RTC::load(const std::vector<u8>& data)
+{
+    if(data.size() != RTC_SAVE_SIZE && data.size() != RTC_SAVE_SIZE_32BIT)
+    {
+        if(!data.empty())
+        {
+            WARN("Unknown RTC save size of " << std::dec << data.size() << " bytes, resetting the clock.");
+        }
+        return;
+    }
+
+    auto readLE = [&data](u32 offset, u32 size) -> u64
+    {
+        u64 val = 0;
+        for(u32 i = 0; i < size; ++i)
+        {
+            val |= static_cast<u64>(data[offset + i]) << (i * CHAR_BIT);
+        }
+        return val;
+    };
+
+    std::array<u8, 5> registers;
+    for(u32 i = 0; i < registers.size(); ++i)
+    {
+        registers[i] = readLE(i * RTC_SAVE_REGISTER_SIZE, 1);
+        m_Latched[i] = readLE((i + registers.size()) * RTC_SAVE_REGISTER_SIZE, 1);
+    }
+
+    m_Base      = toSeconds(registers);
+    m_Carry     = bit_functions::get_bit(registers[DaysHigh], RTC_CARRY_BIT);
+    m_Halted    = bit_functions::get_bit(registers[DaysHigh], RTC_HALT_BIT);
+    m_Reference = now();
+
+    // Catch up on the time spent closed, which only makes sense against the host's clock
+    if(m_Mode == RTCMode::RealTime && !m_Halted)
+    {
+        i64 savedAt = readLE(2 * registers.size() * RTC_SAVE_REGISTER_SIZE, data.size() - 2 * registers.size() * RTC_SAVE_REGISTER_SIZE);
+        i64 elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() - savedAt;
+
+        if(elapsed > 0)
+        {
+            m_Base += elapsed;
+        }
+    }
+
+    DEBUG("Loaded RTC.");
+}
+
+auto RTC::save() const -> std::vector<u8>
+{
+    std::vector<u8> data;
+    data.reserve(RTC_SAVE_SIZE);
+
+    auto writeLE = [&data](u64 val, u32 size)
+    {
+        for(u32 i = 0; i < size; ++i)
+        {
+            data.push_back((val >> (i * CHAR_BIT)) & UINT8_MAX);
+        }
+    };
+
+    for(u8 reg : getRegisters())
+    {
+        writeLE(reg, RTC_SAVE_REGISTER_SIZE);
+    }
+
+    for(u8 reg : m_Latched)
+    {
+        writeLE(reg, RTC_SAVE_REGISTER_SIZE);
+    }
+
+    writeLE(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count(),
+            RTC_SAVE_SIZE - 2 * m_Latched.size() * RTC_SAVE_REGISTER_SIZE);
+
+    return data;
+}
+
+auto RTC::now() const -> u64
+{
+    if(m_Mode == RTCMode::Emulated)
+    {
+        return m_Cycles;
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+auto RTC::unitsPerSecond() const -> u64
+{
+    return (m_Mode == RTCMode::Emulated) ? CLOCK_SPEED : std::micro::den;
+}
+
+void RTC::rebase()
+{
+    u64 current = now();
+
+    if(!m_Halted)
+    {
+        // Keep the fraction of a second in the reference point
+        u64 elapsed = (current - m_Reference) / unitsPerSecond();
+        m_Base      += elapsed;
+        m_Reference += elapsed * unitsPerSecond();
+    }
+    else
+    {
+        m_Reference = current;
+    }
+
+    if(m_Base >= RTC_MAX_DAYS * SECONDS_PER_DAY)
+    {
+        m_Base %= RTC_MAX_DAYS * SECONDS_PER_DAY;
+        m_Carry = true;
+    }
+}
+
+auto RTC::getRegisters() const -> std::array<u8, 5>
+{
+    u64 seconds = m_Base;
+    bool carry  = m_Carry;
+
+    if(!m_Halted)
+    {
+        seconds += (now() - m_Reference) / unitsPerSecond();
+    }
+
+    u64 days = seconds / SECONDS_PER_DAY;
+    if(days >= RTC_MAX_DAYS)
+    {
+        days %= RTC_MAX_DAYS;
+        carry = true;
+    }
+
+    std::array<u8, 5> registers;
+    registers[Seconds]  = seconds % SECONDS_PER_MINUTE;
+    registers[Minutes]  = (seconds / SECONDS_PER_MINUTE) % 60;
+    registers[Hours]    = (seconds / SECONDS_PER_HOUR) % 24;
+    registers[DaysLow]  = days & UINT8_MAX;
+    registers[DaysHigh] = 0;
+
+    bit_functions::set_bit_to(registers[DaysHigh], RTC_DAY_HIGH_BIT, days >> CHAR_BIT);
+    bit_functions::set_bit_to(registers[DaysHigh], RTC_HALT_BIT,     m_Halted);
+    bit_functions::set_bit_to(registers[DaysHigh], RTC_CARRY_BIT,    carry);
+
+    return registers;
+}
+
+auto RTC::toSeconds(const std::array<u8, 5>& registers) -> u64
+{
+    u64 days = registers[DaysLow] | (bit_functions::get_bit(registers[DaysHigh], RTC_DAY_HIGH_BIT) << CHAR_BIT);
+
+    return (registers[Seconds] % SECONDS_PER_MINUTE)
+         + (registers[Minutes] % 60) * SECONDS_PER_MINUTE
+         + (registers[Hours]   % 24) * SECONDS_PER_HOUR
+         + days * SECONDS_PER_DAY;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+#include <vector>
+
+/**
+    RealTime follows the host's clock, and catches up on any time
+    that passed while the emulator was closed. Emulated follows the
+    emulated cycle count instead, so runs are deterministic no matter
+    how fast they are emulated.
+**/
+
+enum class RTCMode
+{
+    RealTime,
+    Emulated
+};
+
+/**
+    The MBC3 real time clock. Rather than ticking, the clock stores
+    its value at a reference point, and works out the registers
+    from the time elapsed since then whenever they're latched.
+
+    https://gbdev.io/pandocs/MBC3.html#the-clock-counter-registers
+**/
+
+class RTC
+{
+    public:
+        RTC(const u64& cycles, RTCMode mode);
+
+        /**
+         * @brief Writes to the latch, latching the clock on a write of 0x00 then 0x01
+         * 
+         * @param val The value written
+         */
+        void latch(u8 val);
+
+        /**
+         * @brief Reads a latched clock register
+         * 
+         * @param reg The register (0x08 - 0x0C)
+         * @return The value of the register when it was last latched
+         */
+        [[nodiscard]] auto read(u8 reg) const -> u8;
+
+        /**
+         * @brief Writes to a clock register
+         * 
+         * @param reg The register (0x08 - 0x0C)
+         * @param val The value to write
+         */
+        void write(u8 reg, u8 val);
+
+        /**
+         * @brief Loads the clock from the trailing bytes of a save
+         * 
+         * @param data The bytes past the end of the cartridge ram
+         */
+        void load(const std::vector<u8>& data);
+
+        /**
+         * @brief Saves the clock in the trailing bytes format
+         * 
+         * @return The bytes to append to the cartridge ram
+         */
+        [[nodiscard]] auto save() const -> std::vector<u8>;
+    private:
+        /**
+         * @brief Gets the current time in the clock's units
+         * 
+         */
+        [[nodiscard]] auto now() const -> u64;
+
+        /**
+         * @brief Gets the number of units per second
+         * 
+         */
+        [[nodiscard]] auto unitsPerSecond() const -> u64;
+
+        /**
+         * @brief Folds the whole seconds elapsed since the reference point into the base
+         * 
+         */
+        void rebase();
+
+        /**
+         * @brief Gets the clock registers for the current time
+         * 
+         */
+        [[nodiscard]] auto getRegisters() const -> std::array<u8, 5>;
+
+        /**
+         * @brief Converts clock registers into a number of seconds
+         * 
+         */
+        [[nodiscard]] static auto toSeconds(const std::array<u8, 5>& registers) -> u64;
+    private:
+        enum Register
+        {
+            Seconds,
+            Minutes,
+            Hours,
+            DaysLow,
+            DaysHigh
+        };
+    private:
+        const u64& m_Cycles;
+        RTCMode m_Mode;
+
+        u64 m_Base;
+        u64 m_Reference;
+
+        bool m_Halted;
+        bool m_Carry;
+
+        std::array<u8, 5> m_Latched;
+        u8 m_LatchValue;
+};
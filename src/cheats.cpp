@@ -0,0 +1,211 @@
+#include "core.hpp"
+
+#include "cheats.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "gameboy.hpp"
+
+Cheats::Cheats(Gameboy& gb)
+    : m_Gameboy(gb), m_PatchedPages({}), m_HasRAMWrites(false) {}
+
+auto Cheats::load(const std::string& path) -> bool
+{
+    std::ifstream file(path);
+    if(!file)
+    {
+        ERROR("Could not open cheats '" << path << "'!");
+        return false;
+    }
+
+    std::string line;
+    while(std::getline(file, line))
+    {
+        line.erase(std::find(line.begin(), line.end(), '#'), line.end());
+
+        std::stringstream ss(line);
+        std::string code;
+        if(!(ss >> code)) continue;
+
+        std::string name;
+        std::getline(ss >> std::ws, name);
+
+        if(!add(code, name))
+        {
+            WARN("Invalid cheat code '" << code << "'.");
+        }
+    }
+
+    DEBUG("Loaded " << std::dec << m_Cheats.size() << " cheat(s) from " << path << ".");
+    return true;
+}
+
+auto Cheats::add(const std::string& code, const std::string& name) -> bool
+{
+    std::optional<Cheat> cheat = (code.find('-') != std::string::npos || code.size() == 6 || code.size() == 9)
+                               ? decodeGameGenie(code)
+                               : decodeGameShark(code);
+
+    if(!cheat) return false;
+
+    cheat->name = name;
+    m_Cheats.push_back(*cheat);
+    update();
+
+    return true;
+}
+
+void Cheats::setEnabled(size_t index, bool enabled)
+{
+    if(index >= m_Cheats.size()) return;
+
+    m_Cheats[index].enabled = enabled;
+    update();
+}
+
+void Cheats::setAllEnabled(bool enabled)
+{
+    for(Cheat& cheat : m_Cheats)
+    {
+        cheat.enabled = enabled;
+    }
+
+    update();
+}
+
+auto Cheats::isAnyEnabled() const -> bool
+{
+    return std::any_of(m_Cheats.begin(), m_Cheats.end(), [](const Cheat& cheat) { return cheat.enabled; });
+}
+
+auto Cheats::getCheats() const -> const std::vector<Cheat>&
+{
+    return m_Cheats;
+}
+
+auto Cheats::isPatched(u8 page) const -> bool
+{
+    return page < m_PatchedPages.size() && m_PatchedPages[page];
+}
+
+void Cheats::patch(u16 address, std::array<u8, PAGE_SIZE>& page) const
+{
+    for(const Cheat& cheat : m_Cheats)
+    {
+        if(!cheat.enabled || cheat.type != Cheat::Type::GameGenie) continue;
+        if(cheat.address / PAGE_SIZE != address / PAGE_SIZE) continue;
+
+        u8& byte = page[cheat.address % PAGE_SIZE];
+
+        // The compare value is checked against the original rom, which
+        // limits the patch to the bank(s) that contain that value
+        if(!cheat.compare || byte == *cheat.compare)
+        {
+            byte = cheat.value;
+        }
+    }
+}
+
+void Cheats::writeRAM()
+{
+    for(const Cheat& cheat : m_Cheats)
+    {
+        if(cheat.enabled && cheat.type == Cheat::Type::GameShark)
+        {
+            m_Gameboy.write(cheat.address, cheat.value);
+        }
+    }
+}
+
+void Cheats::update()
+{
+    m_PatchedPages.fill(false);
+    m_HasRAMWrites = false;
+
+    for(const Cheat& cheat : m_Cheats)
+    {
+        if(!cheat.enabled) continue;
+
+        if(cheat.type == Cheat::Type::GameGenie)
+        {
+            m_PatchedPages[cheat.address / PAGE_SIZE] = true;
+        }
+        else
+        {
+            m_HasRAMWrites = true;
+        }
+    }
+
+    m_Gameboy.remapRom();
+}
+
+auto Cheats::decodeGameGenie(const std::string& code) -> std::optional<Cheat>
+{
+    std::string digits;
+    std::copy_if(code.begin(), code.end(), std::back_inserter(digits), [](char c) { return c != '-'; });
+
+    if((digits.size() != 6 && digits.size() != 9) || digits.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+    {
+        return std::nullopt;
+    }
+
+    auto digit = [&digits](size_t i) -> u8 { return static_cast<u8>(std::stoul(digits.substr(i, 1), nullptr, 16)); };
+
+    Cheat cheat {};
+    cheat.type    = Cheat::Type::GameGenie;
+    cheat.code    = code;
+    cheat.value   = (digit(0) << 4) | digit(1);
+    cheat.address = ((digit(5) ^ 0xF) << 12) | (digit(2) << 8) | (digit(3) << 4) | digit(4);
+    cheat.enabled = true;
+
+    // Game Genie only patches rom
+    if(cheat.address >= ROM_END_ADDR)
+    {
+        return std::nullopt;
+    }
+
+    if(digits.size() == 9)
+    {
+        // The compare value is stored xor'd with 0xBA and rotated left by 2
+        u8 compare = (digit(6) << 4) | digit(8);
+        compare = static_cast<u8>((compare >> 2) | (compare << 6)) ^ 0xBA;
+        cheat.compare = compare;
+    }
+
+    return cheat;
+}
+
+auto Cheats::decodeGameShark(const std::string& code) -> std::optional<Cheat>
+{
+    if(code.size() != 8 || code.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+    {
+        return std::nullopt;
+    }
+
+    u32 raw = std::stoul(code, nullptr, 16);
+
+    u8 type = raw >> 24;
+    if(type != 0x00 && type != 0x01)
+    {
+        // Banked codes (0x8X, 0x9X) write to whichever bank is mapped
+        WARN("GameShark code type 0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<u32>(type)
+             << " is not supported, treating it as 0x01.");
+    }
+
+    Cheat cheat {};
+    cheat.type    = Cheat::Type::GameShark;
+    cheat.code    = code;
+    cheat.value   = (raw >> 16) & 0xFF;
+    cheat.address = ((raw & 0xFF) << 8) | ((raw >> 8) & 0xFF);
+    cheat.enabled = true;
+
+    // GameShark only writes to external and work ram, a write anywhere else could switch banks or poke registers
+    if(cheat.address < RAM_BANK_START_ADDR || cheat.address >= INTERNAL_RAM_END_ADDR)
+    {
+        return std::nullopt;
+    }
+
+    return cheat;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+
+class Gameboy;
+
+/**
+    Game Genie codes patch rom. Rather than checking every read, the
+    MMU maps any rom page containing a patch to a patched copy of
+    that page, built from whichever bank is mapped at the time, so
+    a compare value can pick out the bank a patch belongs to.
+
+    GameShark codes write to ram once per frame at the start of
+    VBlank, the same as the real device.
+
+    Game Genie: ABC-DEF-GHI (or ABC-DEF without a compare value)
+    GameShark:  TTVVLLHH
+**/
+
+struct Cheat
+{
+    enum class Type
+    {
+        GameGenie,
+        GameShark
+    };
+
+    Type type;
+    std::string code;
+    std::string name;
+
+    u16 address;
+    u8  value;
+    std::optional<u8> compare;
+
+    bool enabled;
+};
+
+class Cheats
+{
+    public:
+        Cheats(Gameboy& gb);
+
+        /**
+         * @brief Loads cheats from a file, one code per line
+         * optionally followed by a name, with # starting a comment
+         * 
+         * @param path The filepath to the cheats
+         * @return If the file could be read
+         */
+        auto load(const std::string& path) -> bool;
+
+        /**
+         * @brief Adds a cheat
+         * 
+         * @param code The Game Genie or GameShark code
+         * @param name The name of the cheat
+         * @return If the code was valid
+         */
+        auto add(const std::string& code, const std::string& name = "") -> bool;
+
+        /**
+         * @brief Enables or disables a cheat
+         * 
+         * @param index The index of the cheat
+         * @param enabled If the cheat should be enabled
+         */
+        void setEnabled(size_t index, bool enabled);
+
+        /**
+         * @brief Enables or disables every cheat
+         * 
+         * @param enabled If the cheats should be enabled
+         */
+        void setAllEnabled(bool enabled);
+
+        /**
+         * @brief Checks if any cheat is enabled
+         * 
+         */
+        [[nodiscard]] auto isAnyEnabled() const -> bool;
+
+        /**
+         * @brief Gets the list of cheats
+         * 
+         */
+        [[nodiscard]] auto getCheats() const -> const std::vector<Cheat>&;
+
+        /**
+         * @brief Performs the GameShark ram writes, once per frame at VBlank
+         * 
+         */
+        __always_inline void apply();
+
+        /**
+         * @brief Checks if a rom page has any enabled Game Genie patches
+         * 
+         * @param page The page (high byte of the address) to check
+         */
+        [[nodiscard]] auto isPatched(u8 page) const -> bool;
+
+        /**
+         * @brief Applies the enabled Game Genie patches to a copy of a rom page
+         * 
+         * @param address The address of the start of the page
+         * @param page The contents of the page as currently mapped
+         */
+        void patch(u16 address, std::array<u8, PAGE_SIZE>& page) const;
+    private:
+        /**
+         * @brief Performs the GameShark ram writes
+         * 
+         */
+        void writeRAM();
+
+        /**
+         * @brief Rebuilds the patched pages and notifies the MMU
+         * 
+         */
+        void update();
+
+        /**
+         * @brief Decodes a Game Genie code
+         * 
+         * @param code The code, with or without dashes
+         */
+        [[nodiscard]] static auto decodeGameGenie(const std::string& code) -> std::optional<Cheat>;
+
+        /**
+         * @brief Decodes a GameShark code
+         * 
+         * @param code The code
+         */
+        [[nodiscard]] static auto decodeGameShark(const std::string& code) -> std::optional<Cheat>;
+    private:
+        Gameboy& m_Gameboy;
+
+        std::vector<Cheat> m_Cheats;
+        std::array<bool, ROM_END_ADDR / PAGE_SIZE> m_PatchedPages;
+        bool m_HasRAMWrites;
+};
+
+//--------------------------  Inline function implementations --------------------------//
+
+__always_inline void Cheats::apply()
+{
+    if(m_HasRAMWrites) [[unlikely]]
+    {
+        writeRAM();
+    }
+}
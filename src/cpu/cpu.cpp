@@ -4,6 +4,8 @@
 
 #include "gameboy.hpp"
 
+#include <algorithm>
+
 #ifdef NDEBUG
     #define LOG_OP() ((void)0) //NOLINT(cppcoreguidelines-macro-usage)
 #else
@@ -13,7 +15,8 @@
 CPU::CPU(Gameboy& gb)
     : m_Registers({}), m_Gameboy(gb),
       m_Halted(false), m_HaltBug(false),
-      m_IME(false), m_Branched(false)
+      m_IME(false), m_Branched(false),
+      m_DoubleSpeed(false), m_SpeedSwitchArmed(false), m_StallCycles(0)
 {
     DEBUG("Initializing CPU.");
 }
@@ -33,6 +36,15 @@ void CPU::reset()
         m_Registers.SP() = 0x0000;
         m_Registers.PC() = 0x0000;
     }
+    else if(m_Gameboy.isCGB())
+    {
+        m_Registers.AF() = AF_RESET_CGB;
+        m_Registers.BC() = BC_RESET_CGB;
+        m_Registers.DE() = DE_RESET_CGB;
+        m_Registers.HL() = HL_RESET_CGB;
+        m_Registers.SP() = SP_RESET;
+        m_Registers.PC() = PC_RESET;
+    }
     else
     {
         m_Registers.AF() = AF_RESET;
@@ -54,6 +66,10 @@ void CPU::reset()
     m_IME      = false;
     m_Branched = false;
 
+    m_DoubleSpeed      = false;
+    m_SpeedSwitchArmed = false;
+    m_StallCycles      = 0;
+
     m_Gameboy.resetDiv();
     m_Gameboy.write(TIMER_TIMA_REGISTER, 0);
 }
@@ -72,6 +88,12 @@ auto CPU::tick() -> u8
 {
     if(m_Halted) return 4; // Halted CPU takes 4 cycles
 
+    if(m_StallCycles > 0) [[unlikely]] // Stalled CPU sits out 4 cycles at a time
+    {
+        m_StallCycles -= std::min<u32>(m_StallCycles, 4);
+        return 4;
+    }
+
     Instruction instruction;
     u8 cycles = 0;
     u8 opcode = m_Gameboy.read(m_Registers.PC());
@@ -177,6 +199,31 @@ void CPU::handleInterrupts(u8& cycles)
     }
 }
 
+auto CPU::getRegisters() const -> const Registers&
+{
+    return m_Registers;
+}
+
+auto CPU::getKEY1() const -> u8
+{
+    return 0x7E | (m_DoubleSpeed << 7) | m_SpeedSwitchArmed;
+}
+
+void CPU::setKEY1(u8 val)
+{
+    m_SpeedSwitchArmed = bit_functions::get_bit(val, 0);
+}
+
+auto CPU::isDoubleSpeed() const -> bool
+{
+    return m_DoubleSpeed;
+}
+
+void CPU::stall(u32 cycles)
+{
+    m_StallCycles += cycles;
+}
+
 auto CPU::isFlagSet(const Flags::Register& flag) const -> bool
 {
     return m_Registers.F() & flag;
@@ -58,6 +58,41 @@ class CPU
          */
         void handleInterrupts(u8& cycles);
 
+        /**
+         * @brief Gets the CPU's registers
+         * 
+         * @return The registers
+         */
+        [[nodiscard]] auto getRegisters() const -> const Registers&;
+
+        /**
+         * @brief Gets the value of the KEY1 register: the current speed in
+         * bit 7, and whether a speed switch is armed in bit 0
+         * 
+         */
+        [[nodiscard]] auto getKEY1() const -> u8;
+
+        /**
+         * @brief Writes the KEY1 register, arming a speed switch for the next STOP
+         * 
+         * @param val The value to write
+         */
+        void setKEY1(u8 val);
+
+        /**
+         * @brief Checks if the CPU is running at double speed (CGB only)
+         * 
+         */
+        [[nodiscard]] auto isDoubleSpeed() const -> bool;
+
+        /**
+         * @brief Stops the CPU for a number of cycles, while something
+         * else has the bus (i.e. an HDMA transfer)
+         * 
+         * @param cycles The number of cycles to stop for
+         */
+        void stall(u32 cycles);
+
     private:
         /**
          * @brief Check if a given register flag is set
@@ -112,6 +147,10 @@ class CPU
         bool m_IME;
         bool m_Branched;
 
+        bool m_DoubleSpeed;
+        bool m_SpeedSwitchArmed;
+        u32  m_StallCycles;
+
     private:
         //--------------------------------------Opcode Helpers--------------------------------------//
 
@@ -410,6 +410,17 @@ void CPU::opcode0x10() // STOP
 {
     m_Registers.PC()++; //Skip next opcode
 
+    // With a speed switch armed through KEY1, STOP switches speed instead (CGB only)
+    if(m_SpeedSwitchArmed)
+    {
+        m_DoubleSpeed      = !m_DoubleSpeed;
+        m_SpeedSwitchArmed = false;
+        stall(CYCLES_PER_SPEED_SWITCH);
+
+        OPCODE("Switched to " << (m_DoubleSpeed ? "double" : "single") << " speed!");
+        return;
+    }
+
     OPCODE("Stopped!");
 }
 
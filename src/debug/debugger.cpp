@@ -0,0 +1,493 @@
+#include "core.hpp"
+
+#include "debugger.hpp"
+
+#include <sstream>
+
+#include "flags.hpp"
+#include "gameboy.hpp"
+
+Debugger::Debugger(Gameboy& gb)
+    : m_Gameboy(gb), m_Breakpoints({}), m_BreakpointCount(0),
+      m_Paused(false), m_Stepping(false), m_Steps(0),
+      m_Resuming(false), m_ResumePC(0), m_Inspecting(false) {}
+
+Debugger::~Debugger() = default;
+
+void Debugger::startRepl()
+{
+    m_Repl = std::make_unique<Repl>();
+    pause("Debugger attached, type 'help' for a list of commands.");
+}
+
+void Debugger::startServer(u16 port)
+{
+    m_Repl = std::make_unique<Repl>(port);
+    pause("Debugger attached, type 'help' for a list of commands.");
+}
+
+void Debugger::poll()
+{
+    if(!m_Repl) return;
+
+    while(auto line = m_Repl->poll())
+    {
+        bool paused = m_Paused;
+        execute(*line);
+
+        // Let the emulation run before handling anything queued after a continue or step
+        if(paused && !m_Paused) break;
+    }
+
+    // Once stdin has ended nothing could ever resume the emulation, so stop instead of hanging
+    if(m_Paused && m_Repl->isClosed())
+    {
+        m_Repl->print("Debugger input ended, stopping.");
+        m_Gameboy.stop();
+    }
+}
+
+auto Debugger::isActive() const -> bool
+{
+    return m_BreakpointCount > 0 || !m_Watchpoints.empty() || m_Stepping;
+}
+
+auto Debugger::isPaused() const -> bool
+{
+    return m_Paused;
+}
+
+auto Debugger::shouldBreak(u16 pc) -> bool
+{
+    // Don't immediately break again on the breakpoint we resumed from
+    bool resumed = false;
+    if(m_Resuming)
+    {
+        resumed    = (pc == m_ResumePC);
+        m_Resuming = resumed;
+    }
+
+    if(m_Stepping)
+    {
+        if(m_Steps == 0)
+        {
+            pause("Stepped, " + formatRegisters());
+            return true;
+        }
+
+        --m_Steps;
+    }
+
+    if(!resumed && m_BreakpointCount > 0 && isBreakpoint(m_Gameboy.getRomBank(), pc))
+    {
+        pause("Hit breakpoint, " + formatRegisters());
+        return true;
+    }
+
+    return false;
+}
+
+void Debugger::onWatch(u16 address, u8 val, bool write)
+{
+    if(m_Inspecting) return;
+
+    auto it = m_Watchpoints.find(address);
+    if(it == m_Watchpoints.end()) return;
+
+    u8 flag = write ? Flags::Page::WatchWrite : Flags::Page::WatchRead;
+    if(!(it->second & flag)) return;
+
+    std::stringstream ss;
+    ss << "Hit watchpoint, " << (write ? "wrote 0x" : "read 0x")
+       << std::hex << std::setw(2) << std::setfill('0') << static_cast<u32>(val)
+       << (write ? " to 0x" : " from 0x") << std::setw(4) << address
+       << ", " << formatRegisters();
+    pause(ss.str());
+}
+
+void Debugger::execute(const std::string& line)
+{
+    std::stringstream input(line);
+    std::vector<std::string> args;
+    for(std::string arg; input >> arg;)
+    {
+        args.push_back(arg);
+    }
+
+    if(args.empty())
+    {
+        m_Repl->prompt();
+        return;
+    }
+
+    const std::string& command = args[0];
+    std::stringstream out;
+    out << std::hex << std::setfill('0');
+
+    m_Inspecting = true;
+
+    if(command == "help" || command == "h")
+    {
+        out << "break|b [bank:]addr     Break before executing an address\n"
+            << "delete|d [bank:]addr    Remove a breakpoint\n"
+            << "watch|w addr [r|w|rw]   Break on reads and/or writes to an address\n"
+            << "unwatch|u addr          Remove a watchpoint\n"
+            << "list|l                  List breakpoints and watchpoints\n"
+            << "continue|c              Resume emulation\n"
+            << "step|s [n]              Run n instructions (decimal, 1 by default)\n"
+            << "pause|p                 Pause emulation\n"
+            << "regs|r                  Print the registers\n"
+            << "read|x addr [len]       Print memory\n"
+            << "write|set addr val      Write to memory\n"
+            << "cheats                  List cheats\n"
+            << "cheat add code [name]   Add a Game Genie or GameShark code\n"
+            << "cheat n|all on|off      Enable or disable cheats";
+    }
+    else if(command == "break" || command == "b" || command == "delete" || command == "d")
+    {
+        bool set = (command == "break" || command == "b");
+
+        std::optional<u32> bank = m_Gameboy.getRomBank();
+        std::optional<u32> address;
+
+        if(args.size() > 1)
+        {
+            auto colon = args[1].find(':');
+            if(colon != std::string::npos)
+            {
+                bank    = parseNumber(args[1].substr(0, colon));
+                address = parseNumber(args[1].substr(colon + 1));
+            }
+            else
+            {
+                address = parseNumber(args[1]);
+            }
+        }
+
+        if(!bank || !address || *address > UINT16_MAX)
+        {
+            out << "Usage: " << command << " [bank:]addr";
+        }
+        else if(*bank > UINT16_MAX)
+        {
+            out << "Bank 0x" << *bank << " is out of range, the highest is 0xffff";
+        }
+        else
+        {
+            setBreakpoint(*bank, *address, set);
+            out << (set ? "Set" : "Removed") << " breakpoint at ";
+            if(*address >= ROM_BANK_OFFSET && *address < ROM_END_ADDR)
+            {
+                out << std::setw(2) << *bank << ':';
+            }
+            out << std::setw(4) << *address;
+        }
+    }
+    else if(command == "watch" || command == "w" || command == "unwatch" || command == "u")
+    {
+        std::optional<u32> address = args.size() > 1 ? parseNumber(args[1]) : std::nullopt;
+
+        u8 flags = Flags::Page::PageNone;
+        if(command == "watch" || command == "w")
+        {
+            std::string mode = args.size() > 2 ? args[2] : "w";
+            if(mode.find('r') != std::string::npos) flags |= Flags::Page::WatchRead;
+            if(mode.find('w') != std::string::npos) flags |= Flags::Page::WatchWrite;
+        }
+
+        if(!address || *address > UINT16_MAX)
+        {
+            out << "Usage: " << command << " addr" << (flags ? " [r|w|rw]" : "");
+        }
+        else
+        {
+            setWatchpoint(*address, flags);
+            out << (flags ? "Set" : "Removed") << " watchpoint at " << std::setw(4) << *address;
+        }
+    }
+    else if(command == "list" || command == "l")
+    {
+        for(u32 address = 0; address < 0x10000; ++address)
+        {
+            if(m_Breakpoints[address / WORD_BITS] & (u64(1) << (address % WORD_BITS)))
+            {
+                out << "Breakpoint " << std::setw(4) << address << '\n';
+            }
+        }
+
+        for(const auto& [bank, bitmap] : m_BankedBreakpoints)
+        {
+            for(u32 offset = 0; offset < ROM_BANK_SIZE; ++offset)
+            {
+                if(bitmap[offset / WORD_BITS] & (u64(1) << (offset % WORD_BITS)))
+                {
+                    out << "Breakpoint " << std::setw(2) << bank << ':' << std::setw(4) << (ROM_BANK_OFFSET + offset) << '\n';
+                }
+            }
+        }
+
+        for(const auto& [address, flags] : m_Watchpoints)
+        {
+            out << "Watchpoint " << std::setw(4) << address << ' '
+                << ((flags & Flags::Page::WatchRead)  ? "r" : "")
+                << ((flags & Flags::Page::WatchWrite) ? "w" : "") << '\n';
+        }
+
+        out << std::dec << m_BreakpointCount << " breakpoint(s), " << m_Watchpoints.size() << " watchpoint(s)";
+    }
+    else if(command == "continue" || command == "c")
+    {
+        resume(0);
+        out << "Continuing.";
+    }
+    else if(command == "step" || command == "s")
+    {
+        std::optional<u32> steps = args.size() > 1 ? parseCount(args[1]) : 1;
+        resume((steps && *steps) ? *steps : 1);
+        m_Inspecting = false;
+        return;
+    }
+    else if(command == "pause" || command == "p")
+    {
+        m_Inspecting = false;
+        pause("Paused, " + formatRegisters());
+        return;
+    }
+    else if(command == "regs" || command == "r")
+    {
+        out << formatRegisters();
+    }
+    else if(command == "read" || command == "x")
+    {
+        std::optional<u32> address = args.size() > 1 ? parseNumber(args[1]) : std::nullopt;
+        std::optional<u32> length  = args.size() > 2 ? parseNumber(args[2]) : 1;
+
+        if(!address || !length || *address > UINT16_MAX)
+        {
+            out << "Usage: " << command << " addr [len]";
+        }
+        else
+        {
+            for(u32 i = 0; i < *length && *address + i <= UINT16_MAX; ++i)
+            {
+                if(i % 16 == 0)
+                {
+                    out << (i ? "\n" : "") << std::setw(4) << (*address + i) << ':';
+                }
+                out << ' ' << std::setw(2) << static_cast<u32>(m_Gameboy.read(*address + i));
+            }
+        }
+    }
+    else if(command == "write" || command == "set")
+    {
+        std::optional<u32> address = args.size() > 1 ? parseNumber(args[1]) : std::nullopt;
+        std::optional<u32> val     = args.size() > 2 ? parseNumber(args[2]) : std::nullopt;
+
+        if(!address || !val || *address > UINT16_MAX || *val > UINT8_MAX)
+        {
+            out << "Usage: " << command << " addr val";
+        }
+        else
+        {
+            m_Gameboy.write(*address, *val);
+            out << "Wrote " << std::setw(2) << *val << " to " << std::setw(4) << *address;
+        }
+    }
+    else if(command == "cheats")
+    {
+        const auto& cheats = m_Gameboy.getCheats().getCheats();
+        for(size_t i = 0; i < cheats.size(); ++i)
+        {
+            out << std::dec << i << ": [" << (cheats[i].enabled ? 'x' : ' ') << "] "
+                << cheats[i].code << ' ' << cheats[i].name << '\n';
+        }
+        out << std::dec << cheats.size() << " cheat(s)";
+    }
+    else if(command == "cheat" && args.size() > 2 && args[1] == "add")
+    {
+        std::string name;
+        for(size_t i = 3; i < args.size(); ++i)
+        {
+            name += (i > 3 ? " " : "") + args[i];
+        }
+
+        if(m_Gameboy.getCheats().add(args[2], name))
+        {
+            out << "Added cheat " << args[2];
+        }
+        else
+        {
+            out << "Invalid cheat code '" << args[2] << "'";
+        }
+    }
+    else if(command == "cheat" && args.size() > 2 && (args[2] == "on" || args[2] == "off"))
+    {
+        bool enabled = (args[2] == "on");
+        Cheats& cheats = m_Gameboy.getCheats();
+
+        if(args[1] == "all")
+        {
+            cheats.setAllEnabled(enabled);
+            out << (enabled ? "Enabled" : "Disabled") << " all cheats";
+        }
+        else if(std::optional<u32> index = parseCount(args[1]); index && *index < cheats.getCheats().size())
+        {
+            cheats.setEnabled(*index, enabled);
+            out << (enabled ? "Enabled" : "Disabled") << " cheat " << args[1];
+        }
+        else
+        {
+            out << "No cheat " << args[1];
+        }
+    }
+    else if(command == "cheat")
+    {
+        out << "Usage: cheat add code [name], or cheat n|all on|off";
+    }
+    else
+    {
+        out << "Unknown command '" << command << "', type 'help' for a list of commands.";
+    }
+
+    m_Inspecting = false;
+
+    m_Repl->print(out.str());
+    m_Repl->prompt();
+}
+
+void Debugger::pause(const std::string& reason)
+{
+    m_Paused   = true;
+    m_Stepping = false;
+    m_Steps    = 0;
+
+    if(m_Repl)
+    {
+        m_Repl->print(reason);
+        m_Repl->prompt();
+    }
+}
+
+void Debugger::resume(u32 steps)
+{
+    m_Paused   = false;
+    m_Stepping = steps > 0;
+    m_Steps    = steps;
+
+    m_Resuming = true;
+    m_ResumePC = m_Gameboy.getRegisters().PC();
+}
+
+void Debugger::setBreakpoint(u16 bank, u16 address, bool set)
+{
+    u64* word;
+    u64  bit;
+
+    if(address >= ROM_BANK_OFFSET && address < ROM_END_ADDR)
+    {
+        u16 offset = address - ROM_BANK_OFFSET;
+        word = &m_BankedBreakpoints[bank][offset / WORD_BITS];
+        bit  = u64(1) << (offset % WORD_BITS);
+    }
+    else
+    {
+        word = &m_Breakpoints[address / WORD_BITS];
+        bit  = u64(1) << (address % WORD_BITS);
+    }
+
+    if(set && !(*word & bit))
+    {
+        *word |= bit;
+        ++m_BreakpointCount;
+    }
+    else if(!set && (*word & bit))
+    {
+        *word &= ~bit;
+        --m_BreakpointCount;
+    }
+}
+
+auto Debugger::isBreakpoint(u16 bank, u16 address) const -> bool
+{
+    if(address >= ROM_BANK_OFFSET && address < ROM_END_ADDR)
+    {
+        auto it = m_BankedBreakpoints.find(bank);
+        if(it == m_BankedBreakpoints.end()) return false;
+
+        u16 offset = address - ROM_BANK_OFFSET;
+        return it->second[offset / WORD_BITS] & (u64(1) << (offset % WORD_BITS));
+    }
+
+    return m_Breakpoints[address / WORD_BITS] & (u64(1) << (address % WORD_BITS));
+}
+
+void Debugger::setWatchpoint(u16 address, u8 flags)
+{
+    if(flags == Flags::Page::PageNone)
+    {
+        m_Watchpoints.erase(address);
+    }
+    else
+    {
+        m_Watchpoints[address] = flags;
+    }
+
+    // A page is only as slow as the watchpoints within it need it to be
+    u8 page = address / PAGE_SIZE;
+    u8 pageFlags = Flags::Page::PageNone;
+
+    auto it = m_Watchpoints.lower_bound(page * PAGE_SIZE);
+    for(; it != m_Watchpoints.end() && it->first / PAGE_SIZE == page; ++it)
+    {
+        pageFlags |= it->second;
+    }
+
+    m_Gameboy.setPageFlags(page, pageFlags);
+}
+
+auto Debugger::formatRegisters() const -> std::string
+{
+    const Registers& registers = m_Gameboy.getRegisters();
+
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0')
+       << "PC: " << std::setw(2) << m_Gameboy.getRomBank() << ':' << std::setw(4) << registers.PC()
+       << " AF: " << std::setw(4) << registers.AF()
+       << " BC: " << std::setw(4) << registers.BC()
+       << " DE: " << std::setw(4) << registers.DE()
+       << " HL: " << std::setw(4) << registers.HL()
+       << " SP: " << std::setw(4) << registers.SP();
+
+    return ss.str();
+}
+
+auto Debugger::parseNumber(const std::string& text) -> std::optional<u32>
+{
+    std::string digits = text;
+
+    if(digits.starts_with("0x") || digits.starts_with("0X"))
+    {
+        digits = digits.substr(2);
+    }
+    else if(digits.starts_with('$'))
+    {
+        digits = digits.substr(1);
+    }
+
+    if(digits.empty() || digits.size() > 8 || digits.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+    {
+        return std::nullopt;
+    }
+
+    return static_cast<u32>(std::stoul(digits, nullptr, 16));
+}
+
+auto Debugger::parseCount(const std::string& text) -> std::optional<u32>
+{
+    if(text.empty() || text.size() > 9 || text.find_first_not_of("0123456789") != std::string::npos)
+    {
+        return std::nullopt;
+    }
+
+    return static_cast<u32>(std::stoul(text, nullptr, 10));
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "repl.hpp"
+
+class Gameboy;
+
+/**
+    Execution breakpoints are kept as bitmaps, one for the unbanked
+    address space and one per rom bank for 0x4000-0x7FFF. Watchpoints
+    flag their page in the MMU, so only accesses to those pages leave
+    the fast path. While nothing is set the Gameboy runs its normal
+    frame loop, which never calls into the debugger.
+**/
+
+class Debugger
+{
+    public:
+        Debugger(Gameboy& gb);
+        ~Debugger();
+
+        /**
+         * @brief Starts accepting commands from stdin
+         * 
+         */
+        void startRepl();
+
+        /**
+         * @brief Starts accepting commands from a socket on localhost
+         * 
+         * @param port The port to listen on
+         */
+        void startServer(u16 port);
+
+        /**
+         * @brief Runs any commands that have been entered since the last poll
+         * 
+         */
+        void poll();
+
+        /**
+         * @brief Checks if the emulation needs to run with debugging checks
+         * 
+         */
+        [[nodiscard]] auto isActive() const -> bool;
+
+        /**
+         * @brief Checks if the emulation is paused
+         * 
+         */
+        [[nodiscard]] auto isPaused() const -> bool;
+
+        /**
+         * @brief Checks if the emulation should stop before executing
+         * the instruction at the PC, pausing if so
+         * 
+         * @param pc The address of the next instruction
+         * @return If the emulation was paused
+         */
+        [[nodiscard]] auto shouldBreak(u16 pc) -> bool;
+
+        /**
+         * @brief Notifies the debugger of an access to a watched page
+         * 
+         * @param address The address that was accessed
+         * @param val The value read or being written
+         * @param write If the access was a write
+         */
+        void onWatch(u16 address, u8 val, bool write);
+    private:
+        /**
+         * @brief Parses and runs a single command
+         * 
+         * @param line The command to run
+         */
+        void execute(const std::string& line);
+
+        /**
+         * @brief Pauses the emulation and reports why
+         * 
+         * @param reason The reason for pausing
+         */
+        void pause(const std::string& reason);
+
+        /**
+         * @brief Resumes the emulation
+         * 
+         * @param steps The number of instructions to run before pausing again, or 0 to run freely
+         */
+        void resume(u32 steps);
+
+        /**
+         * @brief Sets or clears an execution breakpoint
+         * 
+         * @param bank The rom bank, only used for 0x4000-0x7FFF
+         * @param address The address of the breakpoint
+         * @param set If the breakpoint should be set or cleared
+         */
+        void setBreakpoint(u16 bank, u16 address, bool set);
+
+        /**
+         * @brief Checks for an execution breakpoint
+         * 
+         * @param bank The rom bank, only used for 0x4000-0x7FFF
+         * @param address The address to check
+         */
+        [[nodiscard]] auto isBreakpoint(u16 bank, u16 address) const -> bool;
+
+        /**
+         * @brief Sets the watch flags of an address, and updates the flags of its page
+         * 
+         * @param address The address to watch
+         * @param flags The Flags::Page watch flags, or PageNone to remove it
+         */
+        void setWatchpoint(u16 address, u8 flags);
+
+        /**
+         * @brief Formats the CPU's registers
+         * 
+         */
+        [[nodiscard]] auto formatRegisters() const -> std::string;
+
+        /**
+         * @brief Parses a hex number, with an optional 0x or $ prefix
+         * 
+         * @param text The text to parse
+         */
+        [[nodiscard]] static auto parseNumber(const std::string& text) -> std::optional<u32>;
+
+        /**
+         * @brief Parses a decimal count, such as the number of instructions to step
+         * 
+         * @param text The text to parse
+         */
+        [[nodiscard]] static auto parseCount(const std::string& text) -> std::optional<u32>;
+    private:
+        static constexpr u32 WORD_BITS = 64;
+
+        using Bitmap     = std::array<u64, 0x10000 / WORD_BITS>;
+        using BankBitmap = std::array<u64, ROM_BANK_SIZE / WORD_BITS>;
+
+        Gameboy& m_Gameboy;
+        std::unique_ptr<Repl> m_Repl;
+
+        Bitmap m_Breakpoints;
+        std::unordered_map<u16, BankBitmap> m_BankedBreakpoints;
+        u32 m_BreakpointCount;
+
+        std::map<u16, u8> m_Watchpoints;
+
+        bool m_Paused;
+        bool m_Stepping;
+        u32  m_Steps;
+
+        bool m_Resuming;
+        u16  m_ResumePC;
+
+        bool m_Inspecting;
+};
@@ -0,0 +1,220 @@
+#include "core.hpp"
+
+#include "repl.hpp"
+
+#include <cerrno>
+#include <iostream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+Repl::Repl()
+    : m_Socket(false), m_Closed(false), m_Listener(-1), m_Client(-1), m_Wake{-1, -1}
+{
+    if(pipe(m_Wake) < 0)
+    {
+        ERROR("Could not create the debugger's wake pipe!");
+        m_Closed = true;
+        return;
+    }
+
+    m_Reader = std::thread(&Repl::readStdin, this);
+}
+
+Repl::Repl(u16 port)
+    : m_Socket(true), m_Closed(false), m_Listener(-1), m_Client(-1), m_Wake{-1, -1}
+{
+    if(pipe(m_Wake) < 0)
+    {
+        ERROR("Could not create the debugger's wake pipe!");
+        m_Closed = true;
+        return;
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if(listener < 0)
+    {
+        ERROR("Could not create debugger socket!");
+        m_Closed = true;
+        return;
+    }
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address {};
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if(bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, 1) < 0)
+    {
+        ERROR("Could not listen for the debugger on port " << std::dec << port << "!");
+        close(listener);
+        m_Closed = true;
+        return;
+    }
+
+    m_Listener = listener;
+    DEBUG("Debugger listening on 127.0.0.1:" << std::dec << port << ".");
+
+    m_Reader = std::thread(&Repl::readSocket, this);
+}
+
+Repl::~Repl()
+{
+    // The byte is never read, so every wait from here on returns straight away
+    if(m_Wake[1] >= 0)
+    {
+        char wake = 0;
+        [[maybe_unused]] ssize_t written = write(m_Wake[1], &wake, 1);
+    }
+
+    if(m_Reader.joinable())
+    {
+        m_Reader.join();
+    }
+
+    if(m_Client >= 0)   close(m_Client);
+    if(m_Listener >= 0) close(m_Listener);
+    if(m_Wake[0] >= 0)  close(m_Wake[0]);
+    if(m_Wake[1] >= 0)  close(m_Wake[1]);
+}
+
+auto Repl::poll() -> std::optional<std::string>
+{
+    std::scoped_lock lock(m_Mutex);
+
+    if(m_Commands.empty())
+    {
+        return std::nullopt;
+    }
+
+    std::string command = std::move(m_Commands.front());
+    m_Commands.pop_front();
+
+    return command;
+}
+
+auto Repl::isClosed() -> bool
+{
+    std::scoped_lock lock(m_Mutex);
+    return m_Closed && m_Commands.empty();
+}
+
+void Repl::print(const std::string& text)
+{
+    if(!m_Socket)
+    {
+        std::cerr << text << std::endl;
+        return;
+    }
+
+    std::scoped_lock lock(m_Mutex);
+
+    if(m_Client < 0) return;
+
+    std::string line = text + '\n';
+    send(m_Client, line.data(), line.size(), MSG_NOSIGNAL);
+}
+
+void Repl::prompt()
+{
+    constexpr auto PROMPT = "(shatter) ";
+
+    if(!m_Socket)
+    {
+        std::cerr << PROMPT << std::flush;
+        return;
+    }
+
+    std::scoped_lock lock(m_Mutex);
+
+    if(m_Client < 0) return;
+
+    send(m_Client, PROMPT, std::char_traits<char>::length(PROMPT), MSG_NOSIGNAL);
+}
+
+void Repl::readStdin()
+{
+    std::string line;
+    char buffer[256];
+    ssize_t size;
+
+    while(waitForInput(STDIN_FILENO) && (size = read(STDIN_FILENO, buffer, sizeof(buffer))) > 0)
+    {
+        queueLines(line, buffer, size);
+    }
+
+    // Nothing more will come, so take the last line even if it wasn't finished
+    std::scoped_lock lock(m_Mutex);
+    if(!line.empty())
+    {
+        m_Commands.push_back(std::move(line));
+    }
+    m_Closed = true;
+}
+
+void Repl::readSocket()
+{
+    while(waitForInput(m_Listener))
+    {
+        int client = accept(m_Listener, nullptr, nullptr);
+        if(client < 0) break;
+
+        {
+            std::scoped_lock lock(m_Mutex);
+            m_Client = client;
+        }
+
+        std::string line;
+        char buffer[256];
+        ssize_t size;
+
+        while(waitForInput(client) && (size = recv(client, buffer, sizeof(buffer), 0)) > 0)
+        {
+            queueLines(line, buffer, size);
+        }
+
+        std::scoped_lock lock(m_Mutex);
+        close(client);
+        m_Client = -1;
+    }
+
+    // No more clients can connect, so nothing more will come
+    std::scoped_lock lock(m_Mutex);
+    m_Closed = true;
+}
+
+auto Repl::waitForInput(int fd) -> bool
+{
+    pollfd fds[2] = {{fd, POLLIN, 0}, {m_Wake[0], POLLIN, 0}};
+
+    while(::poll(fds, 2, -1) < 0)
+    {
+        if(errno != EINTR) return false;
+    }
+
+    return !(fds[1].revents & POLLIN);
+}
+
+void Repl::queueLines(std::string& line, const char* buffer, std::size_t size)
+{
+    for(std::size_t i = 0; i < size; ++i)
+    {
+        if(buffer[i] == '\r') continue;
+
+        if(buffer[i] != '\n')
+        {
+            line += buffer[i];
+            continue;
+        }
+
+        std::scoped_lock lock(m_Mutex);
+        m_Commands.push_back(std::move(line));
+        line.clear();
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+/**
+    Reads debugger commands a line at a time on a background thread,
+    either from stdin or from a single client connected to a socket
+    on localhost. Commands are queued until the emulation thread
+    polls for them, so the debugger itself never runs concurrently
+    with the emulator. Replies to stdin go out on stderr, leaving
+    stdout for frame hashes or a recording.
+**/
+
+class Repl
+{
+    public:
+        /**
+         * @brief Reads commands from stdin
+         * 
+         */
+        Repl();
+
+        /**
+         * @brief Reads commands from a client connected to localhost
+         * 
+         * @param port The port to listen on
+         */
+        Repl(u16 port);
+        ~Repl();
+
+        /**
+         * @brief Gets the next command that has been entered, if any
+         * 
+         */
+        [[nodiscard]] auto poll() -> std::optional<std::string>;
+
+        /**
+         * @brief Checks if the input has ended, so no more commands will come
+         * 
+         */
+        [[nodiscard]] auto isClosed() -> bool;
+
+        /**
+         * @brief Prints a response back to whoever is entering commands
+         * 
+         * @param text The text to print
+         */
+        void print(const std::string& text);
+
+        /**
+         * @brief Prints the prompt for the next command
+         * 
+         */
+        void prompt();
+    private:
+        /**
+         * @brief Reads commands from stdin until it ends or the Repl is destroyed
+         * 
+         */
+        void readStdin();
+
+        /**
+         * @brief Accepts clients and reads their commands until the Repl is destroyed
+         * 
+         */
+        void readSocket();
+
+        /**
+         * @brief Waits for something to read, or for the Repl to be destroyed
+         * 
+         * @param fd The file descriptor to wait on
+         * @return If there is something to read, false if the reading thread should stop
+         */
+        [[nodiscard]] auto waitForInput(int fd) -> bool;
+
+        /**
+         * @brief Splits what was read into lines, and queues up every finished one
+         * 
+         * @param line The line being read, carried over between reads
+         * @param buffer What was read
+         * @param size The number of bytes read
+         */
+        void queueLines(std::string& line, const char* buffer, std::size_t size);
+    private:
+        bool m_Socket;
+
+        // Everything below the mutex is shared with the reading thread
+        std::mutex m_Mutex;
+        std::deque<std::string> m_Commands;
+        bool m_Closed;
+        int  m_Listener;
+        int  m_Client;
+
+        // Written to on destruction, to wake the reading thread out of a blocking read
+        int m_Wake[2];
+
+        std::thread m_Reader;
+};
@@ -0,0 +1,69 @@
+#include "core.hpp"
+
+#include "dirty_map.hpp"
+
+DirtyMap::DirtyMap()
+    : m_PendingVRAM({}), m_PendingPages({}),
+      m_VRAMGenerations({}), m_PageGenerations({}), m_BankGenerations({}),
+      m_Generation(0), m_VRAMGeneration(0) {}
+
+auto DirtyMap::sync() -> u64
+{
+    ++m_Generation;
+
+    constexpr u32 BLOCKS_PER_PAGE = DIRTY_PAGE_SIZE / DIRTY_VRAM_BLOCK_SIZE;
+
+    for(u32 word = 0; word < m_PendingVRAM.size(); ++word)
+    {
+        u64 bits = m_PendingVRAM[word];
+        m_PendingVRAM[word] = 0;
+
+        if(bits)
+        {
+            m_VRAMGeneration = m_Generation;
+        }
+
+        while(bits)
+        {
+            u32 block = word * WORD_BITS + __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            m_VRAMGenerations[block] = m_Generation;
+            m_BankGenerations[block / BANK_BLOCKS] = m_Generation;
+
+            // Keep page queries valid across the whole address space
+            m_PageGenerations[(VRAM_START_ADDR / DIRTY_PAGE_SIZE) + (block % BANK_BLOCKS) / BLOCKS_PER_PAGE] = m_Generation;
+        }
+    }
+
+    for(u32 word = 0; word < m_PendingPages.size(); ++word)
+    {
+        u64 bits = m_PendingPages[word];
+        m_PendingPages[word] = 0;
+
+        while(bits)
+        {
+            u32 page = word * WORD_BITS + __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            m_PageGenerations[page] = m_Generation;
+        }
+    }
+
+    return m_Generation;
+}
+
+auto DirtyMap::getGeneration() const -> u64
+{
+    return m_Generation;
+}
+
+auto DirtyMap::getVRAMGeneration() const -> u64
+{
+    return m_VRAMGeneration;
+}
+
+auto DirtyMap::isPageDirty(u16 address, u64 since) const -> bool
+{
+    return m_PageGenerations[address / DIRTY_PAGE_SIZE] > since;
+}
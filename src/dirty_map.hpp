@@ -0,0 +1,131 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+
+/**
+    Tracks which memory has been written to, so that caches built on
+    top of memory know what to rebuild. VRAM is tracked in 16 byte
+    blocks (a tile row pair, or half a tilemap row), everything else
+    in 256 byte pages.
+
+    The Gameboy Color's second VRAM bank is tracked as if it followed
+    on from the first, so its blocks have addresses from 0xA000 to
+    0xBFFF. Those are only ever seen through the VRAM functions, page
+    queries treat both banks as the same 0x8000-0x9FFF.
+
+    Writes only set a pending bit. sync() folds the pending bits into
+    a generation stamp per block, so any number of consumers can each
+    remember the generation they last synced at, and ask for whatever
+    has changed since then without clearing it for anyone else.
+    Generations are 64 bit, as sync() runs every scanline and a 32 bit
+    count would wrap within days.
+**/
+
+class DirtyMap
+{
+    public:
+        DirtyMap();
+
+        /**
+         * @brief Marks the VRAM block containing an address as written
+         * 
+         * @param address The address within VRAM that was written to,
+         * from 0xA000 for bank 1
+         */
+        __always_inline void markVRAM(u16 address);
+
+        /**
+         * @brief Marks the page containing an address as written
+         * 
+         * @param address The address that was written to
+         */
+        __always_inline void markPage(u16 address);
+
+        /**
+         * @brief Stamps everything written since the last sync
+         * with a new generation
+         * 
+         * @return The new generation, to be passed as `since` next time
+         */
+        auto sync() -> u64;
+
+        /**
+         * @brief Gets the current generation without syncing
+         * 
+         */
+        [[nodiscard]] auto getGeneration() const -> u64;
+
+        /**
+         * @brief Gets the last generation any of VRAM was written in,
+         * so consumers can skip scanning blocks when nothing has changed
+         * 
+         */
+        [[nodiscard]] auto getVRAMGeneration() const -> u64;
+
+        /**
+         * @brief Checks if a page was written to after a generation
+         * 
+         * @param address An address within the page
+         * @param since The generation to compare against
+         */
+        [[nodiscard]] auto isPageDirty(u16 address, u64 since) const -> bool;
+
+        /**
+         * @brief Calls a function with the start address of each VRAM block
+         * written to after a generation
+         * 
+         * @param since The generation to compare against
+         * @param callback The function to call
+         */
+        template <typename F> void forEachDirtyVRAM(u64 since, F&& callback) const;
+    private:
+        static constexpr u32 BANK_BLOCKS = VRAM_BANK_SIZE / DIRTY_VRAM_BLOCK_SIZE;
+        static constexpr u32 VRAM_BLOCKS = VRAM_BANK_COUNT * BANK_BLOCKS;
+        static constexpr u32 PAGES       = 0x10000 / DIRTY_PAGE_SIZE;
+        static constexpr u32 WORD_BITS   = 64;
+
+        std::array<u64, VRAM_BLOCKS / WORD_BITS> m_PendingVRAM;
+        std::array<u64, PAGES / WORD_BITS>       m_PendingPages;
+
+        std::array<u64, VRAM_BLOCKS> m_VRAMGenerations;
+        std::array<u64, PAGES>       m_PageGenerations;
+
+        std::array<u64, VRAM_BANK_COUNT> m_BankGenerations; // The last generation each bank was written in
+
+        u64 m_Generation;
+        u64 m_VRAMGeneration;
+};
+
+//--------------------------  Inline function implementations --------------------------//
+
+__always_inline void DirtyMap::markVRAM(u16 address)
+{
+    u32 block = (address - VRAM_START_ADDR) / DIRTY_VRAM_BLOCK_SIZE;
+    m_PendingVRAM[block / WORD_BITS] |= u64(1) << (block % WORD_BITS);
+}
+
+__always_inline void DirtyMap::markPage(u16 address)
+{
+    u32 page = address / DIRTY_PAGE_SIZE;
+    m_PendingPages[page / WORD_BITS] |= u64(1) << (page % WORD_BITS);
+}
+
+template <typename F>
+void DirtyMap::forEachDirtyVRAM(u64 since, F&& callback) const
+{
+    for(u32 bank = 0; bank < VRAM_BANK_COUNT; ++bank)
+    {
+        // Outside of CGB mode bank 1 is never written, so it's never scanned
+        if(m_BankGenerations[bank] <= since) continue;
+
+        for(u32 block = bank * BANK_BLOCKS; block < (bank + 1) * BANK_BLOCKS; ++block)
+        {
+            if(m_VRAMGenerations[block] > since)
+            {
+                callback(static_cast<u16>(VRAM_START_ADDR + block * DIRTY_VRAM_BLOCK_SIZE));
+            }
+        }
+    }
+}
@@ -33,6 +33,13 @@ namespace Flags
         Joypad      = 0b00010000,
         IntNone     = 0b00000000
     };
+
+    enum Page : u8
+    {
+        WatchRead   = 0b00000001,
+        WatchWrite  = 0b00000010,
+        PageNone    = 0b00000000
+    };
 }
 
 //--------------------------------------Register Flags--------------------------------------//
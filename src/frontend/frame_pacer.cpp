@@ -0,0 +1,103 @@
+#include "core.hpp"
+
+#include "frame_pacer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <ctime>
+#include <thread>
+
+static constexpr i64 NANOSECONDS_PER_SECOND = 1'000'000'000;
+
+FramePacer::FramePacer()
+    : m_Period(0), m_Deadline(0), m_SleepMargin(1'000'000), m_Yield(std::thread::hardware_concurrency() <= 1)
+{
+    resetStats();
+}
+
+void FramePacer::setRate(double fps)
+{
+    m_Period   = fps > 0 ? std::llround(NANOSECONDS_PER_SECOND / fps) : 0;
+    m_Deadline = now();
+}
+
+void FramePacer::wait()
+{
+    if(m_Period == 0)
+    {
+        return;
+    }
+
+    m_Deadline += m_Period;
+
+    i64 current = now();
+    if(current - m_Deadline > MAX_FRAMES_BEHIND * m_Period)
+    {
+        m_Deadline = current;
+        m_Resyncs++;
+        return;
+    }
+
+    // Sleep through most of the wait, and learn from how late the sleep ran
+    i64 wake = m_Deadline - m_SleepMargin;
+    if(current < wake)
+    {
+        timespec until = { static_cast<time_t>(wake / NANOSECONDS_PER_SECOND), static_cast<long>(wake % NANOSECONDS_PER_SECOND) };
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) == EINTR);
+
+        // Grow straight away when a sleep overshoots, and shrink back slowly
+        i64 overshoot = now() - wake + MIN_SLEEP_MARGIN;
+        m_SleepMargin = overshoot > m_SleepMargin ? overshoot : m_SleepMargin - (m_SleepMargin - overshoot) / 16;
+        m_SleepMargin = std::clamp(m_SleepMargin, MIN_SLEEP_MARGIN, MAX_SLEEP_MARGIN);
+    }
+
+    // Then spin the rest of the way
+    while((current = now()) < m_Deadline)
+    {
+        if(m_Yield)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            #if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+            #endif
+        }
+    }
+
+    double lateness = static_cast<double>(current - m_Deadline) / 1000.0;
+    m_Frames++;
+    m_LatenessSum     += lateness;
+    m_LatenessSquares += lateness * lateness;
+    m_MaxLateness      = std::max(m_MaxLateness, lateness);
+}
+
+auto FramePacer::getStats() const -> Stats
+{
+    if(m_Frames == 0)
+    {
+        return { 0, m_Resyncs, 0, 0, 0 };
+    }
+
+    double mean     = m_LatenessSum / m_Frames;
+    double variance = std::max(m_LatenessSquares / m_Frames - mean * mean, 0.0);
+    return { m_Frames, m_Resyncs, mean, m_MaxLateness, std::sqrt(variance) };
+}
+
+void FramePacer::resetStats()
+{
+    m_Frames          = 0;
+    m_Resyncs         = 0;
+    m_LatenessSum     = 0;
+    m_LatenessSquares = 0;
+    m_MaxLateness     = 0;
+}
+
+auto FramePacer::now() -> i64
+{
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<i64>(time.tv_sec) * NANOSECONDS_PER_SECOND + time.tv_nsec;
+}
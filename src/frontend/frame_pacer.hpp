@@ -0,0 +1,90 @@
+#pragma once
+
+#include "core.hpp"
+
+/**
+    Keeps the emulation running at a steady frame rate.
+
+    Each frame is due a fixed period after the one before, counted
+    from an absolute deadline on CLOCK_MONOTONIC rather than from
+    whenever the last frame finished, so rounding and late wakeups
+    never add up to drift. Waiting sleeps until just before the
+    deadline, then spins for the last stretch, since the kernel can
+    wake a sleeping thread late but never early. How long to spin
+    for follows how late sleeps have actually been.
+
+    A frame that's running late starts straight away, so the
+    emulation catches back up. If it falls more than a few frames
+    behind, say while paused in the debugger, the deadlines are
+    moved up to now instead of rushing through the backlog.
+
+    How late each frame actually started is kept, to report jitter.
+**/
+
+class FramePacer
+{
+    public:
+        // In microseconds
+        struct Stats
+        {
+            u64 frames;
+            u64 resyncs;
+            double meanLateness;
+            double maxLateness;
+            double jitter;
+        };
+    public:
+        FramePacer();
+
+        /**
+         * @brief Sets the frame rate to keep to, and starts the next frame's deadline from now
+         * 
+         * @param fps The frames per second, or 0 to not wait at all
+         */
+        void setRate(double fps);
+
+        /**
+         * @brief Waits until the next frame is due
+         * 
+         */
+        void wait();
+
+        /**
+         * @brief Gets how late frames have started since the stats were last reset
+         * 
+         */
+        [[nodiscard]] auto getStats() const -> Stats;
+
+        /**
+         * @brief Resets the stats
+         * 
+         */
+        void resetStats();
+    private:
+        // How far behind the emulation can fall before it gives up catching up
+        static constexpr i64 MAX_FRAMES_BEHIND = 4;
+
+        // Bounds on how long before the deadline sleeping stops and spinning starts, in nanoseconds
+        static constexpr i64 MIN_SLEEP_MARGIN = 100'000;
+        static constexpr i64 MAX_SLEEP_MARGIN = 4'000'000;
+
+        /**
+         * @brief Gets the time on CLOCK_MONOTONIC
+         * 
+         * @return The time in nanoseconds
+         */
+        [[nodiscard]] static auto now() -> i64;
+    private:
+        i64 m_Period;
+        i64 m_Deadline;
+        i64 m_SleepMargin;
+
+        // Spinning on a single core would only keep everything else off it
+        bool m_Yield;
+
+        u64 m_Frames;
+        u64 m_Resyncs;
+        double m_LatenessSum;
+        double m_LatenessSquares;
+        double m_MaxLateness;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <string>
+
+#include "input_queue.hpp"
+#include "video/frame_exchange.hpp"
+
+/**
+    Everything the emulator needs from whatever it's running in:
+    somewhere to show frames, somewhere input comes from, and
+    somewhere to show the title and speed. The Gameboy only talks
+    to its frontend through this, so the core never depends on
+    how, or whether, it's being displayed.
+
+    The frontend runs on the main thread, and the emulation on its
+    own. Input goes over to the emulation through an InputQueue,
+    and frames come back through the FrameExchange.
+
+    SDLFrontend shows the emulator in a window, HeadlessFrontend
+    runs it without a display and makes no SDL calls at all.
+**/
+
+class Frontend
+{
+    public:
+        virtual ~Frontend() = default;
+
+        /**
+         * @brief Shows a finished frame
+         * 
+         * @param frame The frame to show
+         */
+        virtual void present(const FrameExchange::Frame& frame) = 0;
+
+        /**
+         * @brief Handles all the input that's come in since the last call,
+         * queueing up whatever's meant for the Gameboy
+         * 
+         * @param input The queue to the emulation thread
+         */
+        virtual void pollEvents(InputQueue& input) = 0;
+
+        /**
+         * @brief Sets the title shown for the game
+         * 
+         * @param title The title to set
+         */
+        virtual void setTitle(const std::string& title) = 0;
+
+        /**
+         * @brief Shows how fast the emulation is running
+         * 
+         * @param fps The frames emulated per second
+         */
+        virtual void setTitleFPS(float fps) = 0;
+};
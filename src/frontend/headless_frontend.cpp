@@ -0,0 +1,22 @@
+#include "core.hpp"
+
+#include "headless_frontend.hpp"
+
+void HeadlessFrontend::present(const FrameExchange::Frame& frame [[maybe_unused]])
+{}
+
+void HeadlessFrontend::pollEvents(InputQueue& input [[maybe_unused]])
+{}
+
+void HeadlessFrontend::setTitle(const std::string& title)
+{
+    m_Title = title;
+}
+
+void HeadlessFrontend::setTitleFPS(float fps)
+{
+    if(fps > 0)
+    {
+        DEBUG(m_Title << ", " << (fps * TARGET_SPEED_MULTIPLIER) << "% (" << fps << " FPS)");
+    }
+}
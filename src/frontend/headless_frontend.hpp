@@ -0,0 +1,25 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <string>
+
+#include "frontend.hpp"
+
+/**
+    Runs the emulator without a display. Frames are left in the
+    frame exchange for anything that wants them, such as a
+    screenshot, a frame hash stream or a recorder, there's no
+    input, and the speed only goes to the log.
+**/
+
+class HeadlessFrontend : public Frontend
+{
+    public:
+        void present(const FrameExchange::Frame& frame) override;
+        void pollEvents(InputQueue& input) override;
+        void setTitle(const std::string& title) override;
+        void setTitleFPS(float fps) override;
+    private:
+        std::string m_Title;
+};
@@ -0,0 +1,6 @@
+#include "core.hpp"
+
+#include "input_queue.hpp"
+
+InputQueue::InputQueue()
+    : m_Events({}), m_Head(0), m_Tail(0) {}
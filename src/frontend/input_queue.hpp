@@ -0,0 +1,97 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+#include <atomic>
+#include <optional>
+
+#include "joypad.hpp"
+
+/**
+    Carries input from the thread the frontend runs on to the one
+    the emulation runs on, without either side taking a lock.
+
+    A fixed ring of events, with one index the frontend pushes at
+    and one the emulation pops from. Each side only ever writes its
+    own index, so they never contend. If the emulation falls so far
+    behind that the ring fills up, newer events are dropped.
+
+    One producer and one consumer, which may be on different threads.
+**/
+
+struct InputEvent
+{
+    enum class Type : u8
+    {
+        Press,          // Press the button
+        Release,        // Release the button
+        Reset,          // Save and reset the Gameboy
+        ToggleCheats,   // Turn every cheat on, or off if any are on
+        Stop            // Stop the Gameboy
+    };
+
+    Type type;
+    Button button = Button::None;
+};
+
+class InputQueue
+{
+    public:
+        static constexpr u32 CAPACITY = 64;
+    public:
+        InputQueue();
+
+        /**
+         * @brief Adds an event to the back of the queue
+         * 
+         * @param event The event to add
+         * @return Whether there was room for it
+         */
+        __always_inline auto push(const InputEvent& event) -> bool;
+
+        /**
+         * @brief Takes the event at the front of the queue
+         * 
+         * @return The event, or nothing if the queue is empty
+         */
+        [[nodiscard]] __always_inline auto pop() -> std::optional<InputEvent>;
+    private:
+        std::array<InputEvent, CAPACITY> m_Events;
+
+        // Both only ever count up, and wrap around the ring with the modulo
+        alignas(64) std::atomic<u32> m_Head;
+        alignas(64) std::atomic<u32> m_Tail;
+};
+
+//--------------------------  Inline function implementations --------------------------//
+
+__always_inline auto InputQueue::push(const InputEvent& event) -> bool
+{
+    u32 tail = m_Tail.load(std::memory_order_relaxed);
+    if(tail - m_Head.load(std::memory_order_acquire) == CAPACITY)
+    {
+        return false;
+    }
+
+    m_Events[tail % CAPACITY] = event;
+
+    // Release so the consumer sees the event before it sees the new tail
+    m_Tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+__always_inline auto InputQueue::pop() -> std::optional<InputEvent>
+{
+    u32 head = m_Head.load(std::memory_order_relaxed);
+    if(head == m_Tail.load(std::memory_order_acquire))
+    {
+        return std::nullopt;
+    }
+
+    InputEvent event = m_Events[head % CAPACITY];
+
+    // Release so the producer only reuses the slot once it's been read
+    m_Head.store(head + 1, std::memory_order_release);
+    return event;
+}
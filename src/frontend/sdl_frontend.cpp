@@ -0,0 +1,127 @@
+#include "SDL_keyboard.h"
+#include "SDL_keycode.h"
+#include "core.hpp"
+
+#include "sdl_frontend.hpp"
+
+// TODO: Allow for rebinding
+
+/**
+ * @brief Gets the button a key is mapped to
+ * 
+ * @param keycode The key
+ * @return The button, or Button::None if the key isn't mapped
+ */
+static auto getButton(SDL_Keycode keycode) -> Button
+{
+    switch(keycode)
+    {
+        case SDLK_RIGHT:     return Button::Right;
+        case SDLK_LEFT:      return Button::Left;
+        case SDLK_UP:        return Button::Up;
+        case SDLK_DOWN:      return Button::Down;
+
+        case SDLK_z:         return Button::A;
+        case SDLK_x:         return Button::B;
+        case SDLK_BACKSPACE: return Button::Select;
+        case SDLK_RETURN:    return Button::Start;
+    }
+
+    return Button::None;
+}
+
+void SDLFrontend::present(const FrameExchange::Frame& frame)
+{
+    m_Screen.draw(frame);
+}
+
+void SDLFrontend::pollEvents(InputQueue& input)
+{
+    // Take every event waiting, so a burst of input doesn't spill over into later frames
+    SDL_Event e;
+    while(SDL_PollEvent(&e))
+    {
+        Button button;
+        switch(e.type)
+        {
+            case SDL_WINDOWEVENT:
+                if(e.window.event == SDL_WINDOWEVENT_CLOSE)
+                {
+                    input.push({ InputEvent::Type::Stop });
+                }
+                break;
+
+            case SDL_KEYDOWN:
+                if(e.key.repeat) break;
+
+                button = getButton(e.key.keysym.sym);
+                if(button != Button::None)
+                {
+                    input.push({ InputEvent::Type::Press, button });
+                }
+                else
+                {
+                    switch(e.key.keysym.sym)
+                    {
+                        case SDLK_1: Logger::setLogLevel(LogLevel::Opcode);   break;
+                        case SDLK_2: Logger::setLogLevel(LogLevel::Trace);    break;
+                        case SDLK_3: Logger::setLogLevel(LogLevel::Debug);    break;
+                        case SDLK_4: Logger::setLogLevel(LogLevel::Warn);     break;
+                        case SDLK_5: Logger::setLogLevel(LogLevel::Error);    break;
+                        case SDLK_6: Logger::setLogLevel(LogLevel::Critical); break;
+
+                        case SDLK_r:
+                        {
+                            const Uint8* state = SDL_GetKeyboardState(nullptr);
+                            if(state[SDL_SCANCODE_LCTRL])
+                            {
+                                input.push({ InputEvent::Type::Reset });
+                            }
+                            break;
+                        }
+
+                        case SDLK_g:
+                        {
+                            const Uint8* state = SDL_GetKeyboardState(nullptr);
+                            if(state[SDL_SCANCODE_LCTRL])
+                            {
+                                input.push({ InputEvent::Type::ToggleCheats });
+                            }
+                            break;
+                        }
+                    }
+                }
+                break;
+
+            case SDL_KEYUP:
+                if(e.key.repeat) break;
+
+                button = getButton(e.key.keysym.sym);
+                if(button != Button::None)
+                {
+                    input.push({ InputEvent::Type::Release, button });
+                }
+                break;
+        }
+    }
+}
+
+void SDLFrontend::setTitle(const std::string& title)
+{
+    m_Screen.setTitle(title);
+}
+
+void SDLFrontend::setTitleFPS(float fps)
+{
+    m_Screen.setTitleFPS(fps);
+}
+
+void SDLFrontend::setRenderingScale(u8 scale)
+{
+    m_Screen.setRenderingScale(scale);
+}
+
+void SDLFrontend::setScaleFilter(ScaleFilter filter)
+{
+    m_Screen.setScaleFilter(filter);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <string>
+
+#include "frontend.hpp"
+#include "video/screen.hpp"
+
+/**
+    Shows the emulator in an SDL window, and takes input from the
+    keyboard. SDL needs to have been initialized with Screen::initSDL
+    before one is created.
+**/
+
+class SDLFrontend : public Frontend
+{
+    public:
+        void present(const FrameExchange::Frame& frame) override;
+        void pollEvents(InputQueue& input) override;
+        void setTitle(const std::string& title) override;
+        void setTitleFPS(float fps) override;
+
+        /**
+         * @brief Set the rendering scale of the window
+         * 
+         * @param scale The rendering scale to set
+         */
+        void setRenderingScale(u8 scale);
+
+        /**
+         * @brief Set the filter the screen is scaled up with
+         * 
+         * @param filter The filter to scale with
+         */
+        void setScaleFilter(ScaleFilter filter);
+    private:
+        Screen m_Screen;
+};
@@ -5,10 +5,7 @@
 
 Gameboy::Gameboy()
     :   m_MMU(*this), m_APU(*this), m_CPU(*this), m_PPU(*this),
-        m_Cycles(0), m_Timer(*this), m_Path(""), m_Running(false)
-{
-    m_PPU.setDrawCallback([screen = &m_Screen](std::array<u8, FRAME_BUFFER_SIZE> buffer) { screen->draw(buffer); });
-}
+        m_Cycles(0), m_TotalCycles(0), m_Timer(*this), m_Frontend(nullptr), m_Title("Shatter Emulator"), m_Debugger(*this), m_Cheats(*this), m_Path(""), m_Running(false) {}
 
 void Gameboy::reset()
 {
@@ -18,6 +15,11 @@ void Gameboy::reset()
     {
         m_MMU.write(BOOT_REGISTER, 0);
     }
+    else // Otherwise start with the LCD and palette the way the boot rom leaves them
+    {
+        m_MMU.write(LCD_CONTROL_REGISTER, LCDC_RESET);
+        m_MMU.write(BG_PALLETTE_REGISTER, BGP_RESET);
+    }
     
     m_CPU.reset();
 }
@@ -37,6 +39,7 @@ void Gameboy::load(const std::string& path)
 {
     m_Path = path;
     m_MMU.load(m_Path);
+    m_PPU.setCGB(m_MMU.isCGB());
 }
 
 void Gameboy::loadBoot(const std::string& path)
@@ -55,7 +58,7 @@ void Gameboy::start()
     DEBUG("Starting Gameboy.");
     reset();
     m_Running = true;
-    m_Screen.setTitleFPS(0);
+    setTitleFPS(0);
 }
 
 void Gameboy::tick()
@@ -63,16 +66,101 @@ void Gameboy::tick()
     u8 cycles = m_CPU.tick();
     m_CPU.handleInterrupts(cycles);
     m_Timer.update(cycles);
-    m_PPU.tick(cycles);
+    m_MMU.tickDMA(cycles);
+
+    // At double speed the CPU (and the timer and OAM DMA with it) run twice as fast as everything else
+    u8 dots = cycles >> m_CPU.isDoubleSpeed();
+    m_PPU.tick(dots);
     
-    m_Cycles += cycles;
+    m_Cycles += dots;
+    m_TotalCycles += dots;
 }
 
 void Gameboy::renderFrame()
 {
-    while(m_Cycles <= CYCLES_PER_FRAME)
+    emulateFrame();
+    presentFrame();
+}
+
+void Gameboy::emulateFrame()
+{
+    m_Debugger.poll();
+
+    if(!m_Debugger.isPaused())
+    {
+        if(m_Debugger.isActive()) [[unlikely]]
+        {
+            runFrame<true>();
+        }
+        else
+        {
+            runFrame<false>();
+        }
+    }
+}
+
+void Gameboy::presentFrame()
+{
+    // Show the newest finished frame, if there is one and it isn't what's already on screen.
+    // It's taken even without a frontend, so the front buffer always holds the newest frame
+    FrameExchange& frames = m_PPU.getFrameExchange();
+    if(const FrameExchange::Frame* frame = frames.acquire(); frame && m_Frontend && !frames.isFrontUnchanged())
     {
+        m_Frontend->present(*frame);
+    }
+}
+
+void Gameboy::handleInput(InputQueue& input)
+{
+    while(std::optional<InputEvent> event = input.pop())
+    {
+        switch(event->type)
+        {
+            case InputEvent::Type::Press:
+                press(event->button);
+                break;
+            case InputEvent::Type::Release:
+                release(event->button);
+                break;
+            case InputEvent::Type::Reset:
+                save();
+                reset();
+                break;
+            case InputEvent::Type::ToggleCheats:
+                m_Cheats.setAllEnabled(!m_Cheats.isAnyEnabled());
+                break;
+            case InputEvent::Type::Stop:
+                stop();
+                break;
+        }
+    }
+}
+
+template <bool Debug>
+void Gameboy::runFrame()
+{
+    // The frame ends as VBlank starts, so it's shown as soon as it's finished rather than
+    // up to a frame later. With the LCD off there's no VBlank, so a frame's worth of cycles will do
+    u64 frame = m_PPU.getFrameNumber();
+    while(m_Cycles < CYCLES_PER_FRAME)
+    {
+        if constexpr(Debug)
+        {
+            if(m_Debugger.shouldBreak(m_CPU.getRegisters().PC())) return;
+        }
+
         tick();
+
+        if(m_PPU.getFrameNumber() != frame)
+        {
+            m_Cycles = 0;
+            return;
+        }
+
+        if constexpr(Debug)
+        {
+            if(m_Debugger.isPaused()) return;
+        }
     }
 
     m_Cycles -= CYCLES_PER_FRAME;
@@ -88,3 +176,57 @@ auto Gameboy::isRunning() const -> bool
 {
     return m_Running;
 }
+
+void Gameboy::setRTCMode(RTCMode mode)
+{
+    m_MMU.setRTCMode(mode);
+}
+
+void Gameboy::setColourScheme(const Colour::Shades& shades)
+{
+    m_PPU.setColourScheme(shades);
+}
+
+void Gameboy::setRenderSkip(RenderSkip skip, u32 interval)
+{
+    m_PPU.setRenderSkip(skip, interval);
+}
+
+void Gameboy::requestFrame()
+{
+    m_PPU.requestFrame();
+}
+
+void Gameboy::setFrameHashStream(FrameHashStream* stream)
+{
+    m_PPU.setFrameHashStream(stream);
+}
+
+void Gameboy::setRecorder(Recorder* recorder)
+{
+    m_PPU.setRecorder(recorder);
+}
+
+void Gameboy::setFrontend(Frontend* frontend)
+{
+    m_Frontend = frontend;
+    if(m_Frontend)
+    {
+        m_Frontend->setTitle(m_Title);
+    }
+}
+
+void Gameboy::setAccuracy(Accuracy accuracy)
+{
+    switch(accuracy)
+    {
+        case Accuracy::Fast:
+            m_MMU.setDMAMode(DMAMode::Instant);
+            m_PPU.setRenderMode(RenderMode::Scanline);
+            break;
+        case Accuracy::Accurate:
+            m_MMU.setDMAMode(DMAMode::Timed);
+            m_PPU.setRenderMode(RenderMode::PixelFIFO);
+            break;
+    }
+}
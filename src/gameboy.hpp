@@ -9,12 +9,28 @@
 #include "cpu/cpu.hpp"
 #include "cpu/timer.hpp"
 
-#include "video/screen.hpp"
 #include "video/ppu.hpp"
 
 #include "joypad.hpp"
 #include "video/video_defs.hpp"
 
+#include "debug/debugger.hpp"
+
+#include "cheats.hpp"
+
+#include "frontend/frontend.hpp"
+
+/**
+    Fast favours speed wherever timing is unlikely to be relied upon,
+    Accurate models the hardware's timing as closely as possible.
+**/
+
+enum class Accuracy
+{
+    Fast,
+    Accurate
+};
+
 class Gameboy
 {
     public:
@@ -63,11 +79,32 @@ class Gameboy
         void tick();
 
         /**
-         * @brief Renders a single frame of the gameboy
+         * @brief Emulates a single frame of the gameboy, and shows it
          * 
          */
         void renderFrame();
 
+        /**
+         * @brief Emulates a single frame of the gameboy
+         * 
+         */
+        void emulateFrame();
+
+        /**
+         * @brief Shows the newest finished frame on the frontend, if there's
+         * a new one. Safe to call from a different thread to the emulation,
+         * as long as it's always the same one
+         * 
+         */
+        void presentFrame();
+
+        /**
+         * @brief Acts on all the input waiting in a queue
+         * 
+         * @param input The queue from the frontend
+         */
+        void handleInput(InputQueue& input);
+
         /**
          * @brief Stops the Gameboy
          * 
@@ -75,12 +112,76 @@ class Gameboy
         void stop();
 
         /**
-         * @brief Checks if the Gameboy is currently running
+         * @brief Checks if the Gameboy is currently running. Safe to call from any thread
          * 
          * @return The state of the Gameboy
          */
         auto isRunning() const -> bool;
 
+        /**
+         * @brief Sets the accuracy tier of the emulation
+         * 
+         * @param accuracy The accuracy tier to use
+         */
+        void setAccuracy(Accuracy accuracy);
+
+        /**
+         * @brief Sets what the cartridge's real time clock follows,
+         * which needs to be set before loading a rom
+         * 
+         * @param mode The RTC mode to use
+         */
+        void setRTCMode(RTCMode mode);
+
+        /**
+         * @brief Sets the host colours the four shades are drawn with
+         * 
+         * @param shades The colours, from lightest to darkest
+         */
+        void setColourScheme(const Colour::Shades& shades);
+
+        /**
+         * @brief Sets which frames get rendered, while keeping the PPU's timing
+         * 
+         * @param skip When to skip rendering
+         * 
+         * @param interval For RenderSkip::Interval, render one frame in this many
+         */
+        void setRenderSkip(RenderSkip skip, u32 interval = 1);
+
+        /**
+         * @brief Asks for the next frame to be rendered, when rendering on demand
+         * 
+         */
+        void requestFrame();
+
+        /**
+         * @brief Sets the stream the hash of each rendered frame is written to
+         * 
+         * @param stream The stream to write to, or nullptr to stop hashing
+         */
+        void setFrameHashStream(FrameHashStream* stream);
+
+        /**
+         * @brief Sets the recorder each rendered frame is handed to
+         * 
+         * @param recorder The recorder, or nullptr to stop recording
+         */
+        void setRecorder(Recorder* recorder);
+
+        /**
+         * @brief Sets the frontend finished frames are shown on, and the title is shown in
+         * 
+         * @param frontend The frontend, or nullptr to run without one
+         */
+        void setFrontend(Frontend* frontend);
+
+        /**
+         * @brief Gets the number of cycles emulated since the Gameboy was created
+         * 
+         */
+        [[nodiscard]] __always_inline auto getTotalCycles() const -> const u64&;
+
         /**
          * @brief Reads a byte from the specified memory address
          * 
@@ -104,6 +205,82 @@ class Gameboy
          */
         [[nodiscard]] __always_inline auto isBootEnabled() const -> u8;
 
+        /**
+         * @brief Checks if the loaded cart runs in CGB mode
+         * 
+         */
+        [[nodiscard]] __always_inline auto isCGB() const -> bool;
+
+        /**
+         * @brief Gets the map of which memory has been written to
+         * 
+         */
+        [[nodiscard]] __always_inline auto getDirtyMap() -> DirtyMap&;
+
+        /**
+         * @brief Gets the exchange finished frames are published to
+         * 
+         */
+        [[nodiscard]] __always_inline auto getFrameExchange() -> FrameExchange&;
+
+        /**
+         * @brief Gets VRAM, for the PPU to read directly
+         * 
+         * @return A pointer to 0x8000
+         */
+        [[nodiscard]] __always_inline auto getVRAM() const -> const u8*;
+
+        /**
+         * @brief Gets OAM, for the PPU to read directly
+         * 
+         * @return A pointer to 0xFE00
+         */
+        [[nodiscard]] __always_inline auto getOAM() const -> const u8*;
+
+        /**
+         * @brief Gets the rom bank currently mapped to 0x4000-0x7FFF
+         * 
+         */
+        [[nodiscard]] __always_inline auto getRomBank() const -> u16;
+
+        /**
+         * @brief Sets the flags of a memory page
+         * 
+         * @param page The page (high byte of the address) to set the flags of
+         * @param flags The flags to set
+         */
+        __always_inline void setPageFlags(u8 page, u8 flags);
+
+        /**
+         * @brief Gets the CPU's registers
+         * 
+         */
+        [[nodiscard]] __always_inline auto getRegisters() const -> const Registers&;
+
+        /**
+         * @brief Gets the debugger
+         * 
+         */
+        [[nodiscard]] __always_inline auto getDebugger() -> Debugger&;
+
+        /**
+         * @brief Gets the cheats
+         * 
+         */
+        [[nodiscard]] __always_inline auto getCheats() -> Cheats&;
+
+        /**
+         * @brief Performs the once per frame cheat ram writes
+         * 
+         */
+        __always_inline void applyCheats();
+
+        /**
+         * @brief Rebuilds the rom page table after the cheats have changed
+         * 
+         */
+        __always_inline void remapRom();
+
         /**
          * @brief Gets the status of the IME (interrupt master enable)
          * 
@@ -152,12 +329,6 @@ class Gameboy
          */
         [[nodiscard]]  __always_inline auto getInput() -> u8;
 
-        /**
-         * @brief Gets the button from an SDL keycode
-         * 
-         */
-        [[nodiscard]] __always_inline auto getButton(SDL_Keycode keycode) -> Button;
-
         /**
          * @brief Gets the value of the DIV register
          * 
@@ -177,45 +348,87 @@ class Gameboy
          */
         __always_inline void setTimerSpeed(u32 speed);
 
+        /**
+         * @brief Gets the value of the KEY1 (speed switch) register
+         * 
+         */
+        __always_inline auto getKEY1() const -> u8;
 
         /**
-         * @brief Get the video mode of the PPU
+         * @brief Writes the KEY1 (speed switch) register
          * 
+         * @param val The value to write
          */
-        __always_inline auto getVideoMode() const -> VideoMode;
+        __always_inline void setKEY1(u8 val);
 
         /**
-         * @brief Set the title of the window
+         * @brief Checks if the CPU is running at double speed
          * 
-         * @param title The title to set
          */
-        __always_inline void setTitle(std::string title);
+        __always_inline auto isDoubleSpeed() const -> bool;
 
         /**
-         * @brief Get the title of the window
+         * @brief Stops the CPU for a number of cycles while an HDMA transfer has the bus
          * 
+         * @param cycles The number of cycles to stop for
          */
-        __always_inline auto getTitle(std::string title) const -> const std::string&;
+        __always_inline void stallCPU(u32 cycles);
 
         /**
-         * @brief Set the fps in the title of the window
+         * @brief Copies the next block of an HBlank HDMA transfer, as HBlank starts
          * 
-         * @param fps The fps to set
          */
-        __always_inline void setTitleFPS(u32 fps);
+        __always_inline void stepHDMA();
+
+        /**
+         * @brief Reads one of the LCD registers the PPU owns
+         * 
+         * @param address The register's address
+         */
+        __always_inline auto readVideoRegister(u16 address) const -> u8;
+
+        /**
+         * @brief Writes one of the LCD registers the PPU owns
+         * 
+         * @param address The register's address
+         * 
+         * @param val The value to write
+         */
+        __always_inline void writeVideoRegister(u16 address, u8 val);
+
+
+        /**
+         * @brief Get the video mode of the PPU
+         * 
+         */
+        __always_inline auto getVideoMode() const -> VideoMode;
+
+        /**
+         * @brief Set the title shown on the frontend
+         * 
+         * @param title The title to set
+         */
+        __always_inline void setTitle(std::string title);
 
         /**
-         * @brief Set the rendering scale of the window
+         * @brief Get the title shown on the frontend
          * 
-         * @param scale The rendering scale to set
          */
-        __always_inline void setRenderingScale(u8 renderingScale);
+        __always_inline auto getTitle() const -> const std::string&;
 
         /**
-         * @brief Get the rendering scale of the window
+         * @brief Set the fps shown on the frontend
+         * 
+         * @param fps The fps to set
+         */
+        __always_inline void setTitleFPS(float fps);
+    private:
+        /**
+         * @brief Runs the emulation until the end of the frame, or until the debugger pauses it
          * 
+         * @tparam Debug If the debugger needs to check every instruction
          */
-        __always_inline auto getRenderingScale() const -> u32;
+        template <bool Debug> void runFrame();
     private:
         MMU m_MMU;
         APU m_APU;
@@ -223,14 +436,20 @@ class Gameboy
         PPU m_PPU;
 
         u32 m_Cycles;
+        u64 m_TotalCycles;
 
         Joypad m_Joypad;
         Timer  m_Timer;
-        Screen m_Screen;
+
+        Frontend*   m_Frontend;
+        std::string m_Title;
+
+        Debugger m_Debugger;
+        Cheats   m_Cheats;
 
         std::string m_Path;
         std::string m_BootPath;
-        bool m_Running;
+        std::atomic<bool> m_Running;
 };
 
 //--------------------------  Inline function implementations --------------------------//
@@ -250,6 +469,71 @@ __always_inline auto Gameboy::isBootEnabled() const -> u8
     return m_MMU.isBootEnabled();
 }
 
+__always_inline auto Gameboy::getTotalCycles() const -> const u64&
+{
+    return m_TotalCycles;
+}
+
+__always_inline auto Gameboy::isCGB() const -> bool
+{
+    return m_MMU.isCGB();
+}
+
+__always_inline auto Gameboy::getDirtyMap() -> DirtyMap&
+{
+    return m_MMU.getDirtyMap();
+}
+
+__always_inline auto Gameboy::getFrameExchange() -> FrameExchange&
+{
+    return m_PPU.getFrameExchange();
+}
+
+__always_inline auto Gameboy::getVRAM() const -> const u8*
+{
+    return m_MMU.getVRAM();
+}
+
+__always_inline auto Gameboy::getOAM() const -> const u8*
+{
+    return m_MMU.getOAM();
+}
+
+__always_inline auto Gameboy::getRomBank() const -> u16
+{
+    return m_MMU.getRomBank();
+}
+
+__always_inline void Gameboy::setPageFlags(u8 page, u8 flags)
+{
+    m_MMU.setPageFlags(page, flags);
+}
+
+__always_inline auto Gameboy::getRegisters() const -> const Registers&
+{
+    return m_CPU.getRegisters();
+}
+
+__always_inline auto Gameboy::getDebugger() -> Debugger&
+{
+    return m_Debugger;
+}
+
+__always_inline auto Gameboy::getCheats() -> Cheats&
+{
+    return m_Cheats;
+}
+
+__always_inline void Gameboy::applyCheats()
+{
+    m_Cheats.apply();
+}
+
+__always_inline void Gameboy::remapRom()
+{
+    m_MMU.mapRom(true);
+}
+
 __always_inline auto Gameboy::getIME() const -> bool
 {
     return m_CPU.getIME();
@@ -287,11 +571,6 @@ __always_inline auto Gameboy::getInput() -> u8
 }
 
 
-__always_inline auto Gameboy::getButton(SDL_Keycode keycode) -> Button
-{
-    return m_Joypad.getButton(keycode);
-}
-
 __always_inline auto Gameboy::getDIV() -> u8
 {
     return m_Timer.getDIV();
@@ -302,37 +581,69 @@ __always_inline void Gameboy::resetDiv()
     m_Timer.resetDiv();
 }
 
-__always_inline void Gameboy::setTimerSpeed(u32 speed)
+__always_inline auto Gameboy::getKEY1() const -> u8
 {
-    m_Timer.setSpeed(speed);
+    return m_CPU.getKEY1();
 }
 
-__always_inline auto Gameboy::getVideoMode() const -> VideoMode
+__always_inline void Gameboy::setKEY1(u8 val)
 {
-    return m_PPU.getMode();
+    m_CPU.setKEY1(val);
 }
 
-__always_inline void Gameboy::setTitle(std::string title)
+__always_inline auto Gameboy::isDoubleSpeed() const -> bool
+{
+    return m_CPU.isDoubleSpeed();
+}
+
+__always_inline void Gameboy::stallCPU(u32 cycles)
+{
+    m_CPU.stall(cycles);
+}
+
+__always_inline void Gameboy::stepHDMA()
+{
+    m_MMU.stepHDMA();
+}
+
+__always_inline auto Gameboy::readVideoRegister(u16 address) const -> u8
 {
-    m_Screen.setTitle(title);
+    return m_PPU.readRegister(address);
 }
 
-__always_inline auto Gameboy::getTitle(std::string title) const -> const std::string&
+__always_inline void Gameboy::writeVideoRegister(u16 address, u8 val)
 {
-    return m_Screen.getTitle();
+    m_PPU.writeRegister(address, val);
+}
+
+__always_inline void Gameboy::setTimerSpeed(u32 speed)
+{
+    m_Timer.setSpeed(speed);
 }
 
-__always_inline void Gameboy::setTitleFPS(u32 fps)
+__always_inline auto Gameboy::getVideoMode() const -> VideoMode
+{
+    return m_PPU.getMode();
+}
+
+__always_inline void Gameboy::setTitle(std::string title)
 {
-    m_Screen.setTitleFPS(fps);
+    m_Title = title;
+    if(m_Frontend)
+    {
+        m_Frontend->setTitle(m_Title);
+    }
 }
 
-__always_inline void Gameboy::setRenderingScale(u8 renderingScale)
+__always_inline auto Gameboy::getTitle() const -> const std::string&
 {
-    m_Screen.setRenderingScale(renderingScale);
+    return m_Title;
 }
 
-__always_inline auto Gameboy::getRenderingScale() const -> u32
+__always_inline void Gameboy::setTitleFPS(float fps)
 {
-    return m_Screen.getRenderingScale();
+    if(m_Frontend)
+    {
+        m_Frontend->setTitleFPS(fps);
+    }
 }
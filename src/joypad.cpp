@@ -78,23 +78,3 @@ auto Joypad::getInput() -> u8
 
     return 0xFF;
 }
-
-// TODO: Allow for rebinding
-
-auto Joypad::getButton(SDL_Keycode keycode) -> Button
-{
-    switch(keycode)
-    {
-        case SDLK_RIGHT:     return Button::Right;
-        case SDLK_LEFT:      return Button::Left;
-        case SDLK_UP:        return Button::Up;
-        case SDLK_DOWN:      return Button::Down;
-
-        case SDLK_z:         return Button::A;
-        case SDLK_x:         return Button::B;
-        case SDLK_BACKSPACE: return Button::Select;
-        case SDLK_RETURN:    return Button::Start;
-    }
-
-    return Button::None;
-}
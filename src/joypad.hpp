@@ -2,8 +2,6 @@
 
 #include "core.hpp"
 
-#include "SDL_keycode.h"
-
 /**
     The eight Game Boy action/direction buttons are arranged
     as a 2x4 matrix. Select either action or direction buttons
@@ -50,12 +48,6 @@ class Joypad
          * 
          */
         [[nodiscard]] auto getInput() -> u8;
-
-        /**
-         * @brief Convert an SDL2 keycode to 
-         * 
-         */
-        [[nodiscard]] auto getButton(SDL_Keycode keycode) -> Button;
     private:
 
         /**
@@ -1,25 +1,40 @@
-#include "SDL_keyboard.h"
-#include "SDL_keycode.h"
-#include "SDL_timer.h"
 #include "core.hpp"
 
 #include "CLI11.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <thread>
 
 #include "gameboy.hpp"
-#include "video/screen.hpp"
+#include "frontend/frame_pacer.hpp"
+#include "frontend/headless_frontend.hpp"
+#include "frontend/sdl_frontend.hpp"
 
 auto run(int argc, char** argv) -> int;
-void pollEvents(Gameboy* gb);
+void emulate(Gameboy* gb, InputQueue* input, double targetFPS, u64 frameLimit, std::atomic<u64>* frames);
+void reportPacing(FramePacer& pacer);
+auto parseColourScheme(const std::string& scheme) -> std::optional<Colour::Shades>;
+auto writeScreenshot(const std::string& path, const FrameExchange::Frame& frame) -> bool;
 
 auto main(int argc, char** argv) -> int
 {
     // SDL Segfaults if I don't calll _Exit, so this is 
     // just a hack to get around that, while preserving
     // a stack for objects to get destroyed
-    _Exit(run(argc, argv));
+    int result = run(argc, argv);
+
+    // _Exit doesn't flush anything, so the end of the log would be lost
+    std::cout.flush();
+    std::cerr.flush();
+    _Exit(result);
 }
 
 auto run(int argc, char** argv) -> int
@@ -40,8 +55,72 @@ auto run(int argc, char** argv) -> int
     u8 renderingScale = 0;
     shatter.add_option("-s, --scale, --rendering-scale", renderingScale, "Change the rendering scale of the window.");
 
-    u32 targetFPS = 60;
-    shatter.add_option("--fps,--frame-rate", targetFPS, "Set the desired fps of the emulation. Set to 0 for unlimited.");
+    ScaleFilter scaleFilter = ScaleFilter::None;
+    std::map<std::string, ScaleFilter> scaleFilters {{"none", ScaleFilter::None}, {"nearest", ScaleFilter::Nearest}, {"scale2x", ScaleFilter::Scale2x},
+                                                     {"scale3x", ScaleFilter::Scale3x}, {"xbr", ScaleFilter::XBR}};
+    shatter.add_option("--filter", scaleFilter, "Scale the screen up on the CPU (none, nearest, scale2x, scale3x or xbr).")
+           ->transform(CLI::CheckedTransformer(scaleFilters, CLI::ignore_case));
+
+    double targetFPS = FRAME_RATE;
+    CLI::Option* fpsOption = shatter.add_option("--fps,--frame-rate", targetFPS, "Set the desired fps of the emulation, the DMG's own 59.7275 by default. Set to 0 for unlimited. Unlimited by default when headless.");
+
+    bool headless = false;
+    shatter.add_flag("--headless", headless, "Run without a window, making no SDL calls.");
+
+    u64 frameLimit = 0;
+    shatter.add_option("--frames", frameLimit, "Stop after emulating this many frames.");
+
+    std::string screenshotPath;
+    shatter.add_option("--screenshot", screenshotPath, "Save the last frame as a PPM image when the emulator stops.");
+
+    Accuracy accuracy = Accuracy::Fast;
+    std::map<std::string, Accuracy> accuracies {{"fast", Accuracy::Fast}, {"accurate", Accuracy::Accurate}};
+    shatter.add_option("-a,--accuracy", accuracy, "Set the accuracy tier of the emulation (fast or accurate).")
+           ->transform(CLI::CheckedTransformer(accuracies, CLI::ignore_case));
+
+    std::string cheatsPath;
+    shatter.add_option("-c,--cheats", cheatsPath, "Path to a list of Game Genie and GameShark codes.");
+
+    RTCMode rtcMode = RTCMode::RealTime;
+    std::map<std::string, RTCMode> rtcModes {{"real", RTCMode::RealTime}, {"emulated", RTCMode::Emulated}};
+    shatter.add_option("--rtc", rtcMode, "Set what the cartridge clock follows (real or emulated time).")
+           ->transform(CLI::CheckedTransformer(rtcModes, CLI::ignore_case));
+
+    std::string colourScheme = "green";
+    shatter.add_option("--colours,--colors", colourScheme, "Set the screen colours (green, grey, or four RRGGBB hex colours from lightest to darkest, separated by commas).");
+
+    u32 renderEvery = 1;
+    shatter.add_option("--render-every", renderEvery, "Only render one frame in this many, keeping the emulation speed. Set to 0 to never render.");
+
+    std::string hashPath;
+    shatter.add_option("--hash-frames", hashPath, "Write a hash of every rendered frame to a file, or - for stdout.");
+
+    u32 hashEvery = 1;
+    shatter.add_option("--hash-every", hashEvery, "Only hash one frame in this many.");
+
+    FrameHash::Format hashFormat = FrameHash::Format::Binary;
+    std::map<std::string, FrameHash::Format> hashFormats {{"binary", FrameHash::Format::Binary}, {"csv", FrameHash::Format::CSV}};
+    shatter.add_option("--hash-format", hashFormat, "Set the format frame hashes are written in (binary or csv).")
+           ->transform(CLI::CheckedTransformer(hashFormats, CLI::ignore_case));
+
+    std::string recordPath;
+    shatter.add_option("--record", recordPath, "Record every rendered frame to a file, or - for stdout.");
+
+    RecordFormat recordFormat = RecordFormat::Y4M;
+    std::map<std::string, RecordFormat> recordFormats {{"y4m", RecordFormat::Y4M}, {"rgba", RecordFormat::RGBA}, {"indexed", RecordFormat::Indexed}};
+    shatter.add_option("--record-format", recordFormat, "Set the format frames are recorded in (y4m, rgba or indexed).")
+           ->transform(CLI::CheckedTransformer(recordFormats, CLI::ignore_case));
+
+    RecordPolicy recordPolicy = RecordPolicy::Drop;
+    std::map<std::string, RecordPolicy> recordPolicies {{"drop", RecordPolicy::Drop}, {"wait", RecordPolicy::Wait}};
+    shatter.add_option("--record-policy", recordPolicy, "Set what happens to frames when recording falls behind (drop them, or wait for the recording).")
+           ->transform(CLI::CheckedTransformer(recordPolicies, CLI::ignore_case));
+
+    bool debug = false;
+    shatter.add_flag("-d,--debug", debug, "Start paused with the debugger reading commands from stdin.");
+
+    u16 debugPort = 0;
+    shatter.add_option("--debug-port", debugPort, "Start paused with the debugger reading commands from a socket on localhost.");
 
     #ifndef NDEBUG
         bool verbose = false;
@@ -72,11 +151,23 @@ auto run(int argc, char** argv) -> int
         return -3;
     }
 
+    std::optional<Colour::Shades> shades = parseColourScheme(colourScheme);
+    if(!shades)
+    {
+        ERROR("Invalid colour scheme '" << colourScheme << "'!");
+        return -4;
+    }
+
     if(!logPath.empty())
     {
         std::ofstream file(logPath);
         Logger::setDefaultStream(file);
     }
+    else if(hashPath == "-" || recordPath == "-")
+    {
+        // Keep the log out of whatever's being piped through stdout
+        Logger::setDefaultStream(std::cerr);
+    }
 
     #ifndef NDEBUG
         if(verbose)
@@ -85,9 +176,35 @@ auto run(int argc, char** argv) -> int
         }
     #endif
 
-    Screen::initSDL();
+    // The frontend is created first, so it gets the title when the rom loads
+    std::unique_ptr<Frontend> frontend;
+    if(headless)
+    {
+        frontend = std::make_unique<HeadlessFrontend>();
+
+        // Nobody's watching, so run as fast as possible unless asked not to
+        if(fpsOption->count() == 0)
+        {
+            targetFPS = 0;
+        }
+    }
+    else
+    {
+        Screen::initSDL();
+
+        std::unique_ptr<SDLFrontend> sdl = std::make_unique<SDLFrontend>();
+        if(renderingScale > 0)
+        {
+            sdl->setRenderingScale(renderingScale);
+        }
+        sdl->setScaleFilter(scaleFilter);
+
+        frontend = std::move(sdl);
+    }
 
     Gameboy* gb = new Gameboy;
+    gb->setFrontend(frontend.get());
+    gb->setRTCMode(rtcMode);
     gb->load(path);
 
     if(!bootPath.empty())
@@ -95,119 +212,215 @@ auto run(int argc, char** argv) -> int
         gb->loadBoot(bootPath);
     }
 
-    if(renderingScale > 0)
+    gb->setAccuracy(accuracy);
+    gb->setColourScheme(*shades);
+
+    if(renderEvery == 0)
+    {
+        gb->setRenderSkip(RenderSkip::OnDemand);
+    }
+    else if(renderEvery > 1)
+    {
+        gb->setRenderSkip(RenderSkip::Interval, renderEvery);
+    }
+
+    if(!cheatsPath.empty())
+    {
+        gb->getCheats().load(cheatsPath);
+    }
+
+    // Lives on the stack, so it's flushed when the emulator stops
+    FrameHashStream hashStream;
+    if(!hashPath.empty())
+    {
+        if(!hashStream.open(hashPath, hashFormat, hashEvery))
+        {
+            return -5;
+        }
+
+        gb->setFrameHashStream(&hashStream);
+    }
+
+    // Likewise, so every frame still waiting is written out
+    Recorder recorder;
+    if(!recordPath.empty())
+    {
+        if(!recorder.start(recordPath, recordFormat, recordPolicy, std::max<u32>(renderEvery, 1)))
+        {
+            return -6;
+        }
+
+        gb->setRecorder(&recorder);
+    }
+
+    if(debugPort != 0)
+    {
+        gb->getDebugger().startServer(debugPort);
+    }
+    else if(debug)
     {
-        gb->setRenderingScale(renderingScale);
+        gb->getDebugger().startRepl();
     }
 
     gb->start();
 
-    u64 frameStart, frameEnd, fpsStart, fpsEnd;
-    float frameDelta, fpsDelta;
-    float target;
-    bool unlimited = false;
-    u32 fps = 0;
-    
-    if(targetFPS != 0)
+    // The emulation runs on its own thread, so presenting a frame never holds it up,
+    // while SDL's events and presentation stay on this one, as SDL needs
+    InputQueue input;
+    std::atomic<u64> frames = 0;
+    std::thread emulation(emulate, gb, &input, targetFPS, frameLimit, &frames);
+
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point fpsStart = Clock::now();
+    u64 fpsFrames = 0;
+    while(gb->isRunning())
     {
-        target = 1.0f / targetFPS;
+        Clock::time_point updateStart = Clock::now();
+        frontend->pollEvents(input);
+        gb->presentFrame();
+
+        float fpsDelta = std::chrono::duration<float>(updateStart - fpsStart).count();
+        if(fpsDelta >= DEFAULT_TITLE_UPDATE_RATE)
+        {
+            u64 emulated = frames.load(std::memory_order_relaxed);
+            gb->setTitleFPS(static_cast<float>(emulated - fpsFrames) / fpsDelta);
+            fpsStart = updateStart;
+            fpsFrames = emulated;
+        }
+
+        // Check back often enough to pick up every frame and keep input latency low
+        std::this_thread::sleep_until(updateStart + std::chrono::duration<float>(DEFAULT_FRONTEND_UPDATE_RATE));
     }
-    else
+
+    emulation.join();
+
+    // Take the last frame, so the screenshot is of the newest one
+    gb->presentFrame();
+
+    int result = 0;
+    if(!screenshotPath.empty() && !writeScreenshot(screenshotPath, gb->getFrameExchange().getFrontBuffer()))
     {
-        unlimited = true;
+        ERROR("Could not save a screenshot to '" << screenshotPath << "'!");
+        result = -7;
     }
 
-    fpsStart = SDL_GetPerformanceCounter();
+    // The window has to go before SDL does
+    gb->setFrontend(nullptr);
+    frontend.reset();
+    if(!headless)
+    {
+        Screen::quitSDL();
+    }
+
+    return result;
+}
+
+void emulate(Gameboy* gb, InputQueue* input, double targetFPS, u64 frameLimit, std::atomic<u64>* frames)
+{
+    FramePacer pacer;
+    pacer.setRate(targetFPS);
+
+    bool paused = false;
     while(gb->isRunning())
     {
-        frameStart = SDL_GetPerformanceCounter();
-        pollEvents(gb);
-        gb->renderFrame();
-        frameEnd = SDL_GetPerformanceCounter();
+        gb->handleInput(*input);
+        gb->emulateFrame();
 
-        if(!unlimited)
+        // Nothing is emulated while the debugger holds the emulation, so it isn't counted
+        // towards the frame limit or the speed, and isn't paced, only checked on for commands
+        if(gb->getDebugger().isPaused())
         {
-            frameDelta = (frameEnd - frameStart) / static_cast<float>(SDL_GetPerformanceFrequency());
-            if(frameDelta < target)
-            {
-                SDL_Delay((target - frameDelta) * 1000.0f);
-            }
+            paused = true;
+            std::this_thread::sleep_for(std::chrono::duration<float>(DEBUGGER_PAUSED_POLL_RATE));
+            continue;
         }
-        
-        fpsEnd = SDL_GetPerformanceCounter();
-        fpsDelta = (fpsEnd - fpsStart) / static_cast<float>(SDL_GetPerformanceFrequency());
-        if(fpsDelta >= DEFAULT_TITLE_UPDATE_RATE)
+
+        // Start the deadlines over, rather than rushing to catch up on the time spent paused
+        if(paused)
         {
-            gb->setTitleFPS(static_cast<float>(fps) / fpsDelta);
-            fpsStart = fpsEnd;
-            fps = 0;
+            paused = false;
+            pacer.setRate(targetFPS);
         }
-        else
+
+        u64 emulated = frames->fetch_add(1, std::memory_order_relaxed) + 1;
+        if(frameLimit != 0 && emulated >= frameLimit)
         {
-            ++fps;
+            gb->stop();
+        }
+
+        pacer.wait();
+
+        if(emulated % PACING_REPORT_INTERVAL == 0 || !gb->isRunning())
+        {
+            reportPacing(pacer);
         }
     }
+}
 
-    Screen::quitSDL();
+void reportPacing(FramePacer& pacer)
+{
+    FramePacer::Stats stats = pacer.getStats();
+    if(stats.frames == 0)
+    {
+        return;
+    }
 
-    return 0;
+    DEBUG("Frame pacing over " << stats.frames << " frames: " << std::fixed << std::setprecision(1)
+          << stats.meanLateness << "us late on average, " << stats.maxLateness << "us at worst, "
+          << stats.jitter << "us jitter, " << stats.resyncs << " resyncs.");
+    pacer.resetStats();
 }
 
-void pollEvents(Gameboy* gb)
+auto parseColourScheme(const std::string& scheme) -> std::optional<Colour::Shades>
 {
-    SDL_Event e;
-    if (SDL_PollEvent(&e))
+    if(scheme == "green")
+    {
+        return Colour::GREEN_SHADES;
+    }
+
+    if(scheme == "grey" || scheme == "gray")
     {
-        Button button;
-        switch(e.type)
+        return Colour::GREY_SHADES;
+    }
+
+    Colour::Shades shades;
+    std::stringstream ss(scheme);
+    std::string colour;
+
+    for(Colour::ScreenColour& shade : shades)
+    {
+        if(!std::getline(ss, colour, ',') || colour.size() != 6 || colour.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
         {
-            case SDL_WINDOWEVENT:
-                if(e.window.event == SDL_WINDOWEVENT_CLOSE)
-                {
-                    gb->stop();
-                }
-                break;
-
-            case SDL_KEYDOWN:
-                if(e.key.repeat) break;
-                
-                button = gb->getButton(e.key.keysym.sym);
-                if(button != Button::None)
-                {
-                    gb->press(button);
-                }
-                else
-                {
-                    switch(e.key.keysym.sym)
-                    {
-                        case SDLK_1: Logger::setLogLevel(LogLevel::Opcode);   break;
-                        case SDLK_2: Logger::setLogLevel(LogLevel::Trace);    break;
-                        case SDLK_3: Logger::setLogLevel(LogLevel::Debug);    break;
-                        case SDLK_4: Logger::setLogLevel(LogLevel::Warn);     break;
-                        case SDLK_5: Logger::setLogLevel(LogLevel::Error);    break;
-                        case SDLK_6: Logger::setLogLevel(LogLevel::Critical); break;
-
-                        case SDLK_r:
-                            const Uint8* state = SDL_GetKeyboardState(nullptr);
-                            if(state[SDL_SCANCODE_LCTRL])
-                            {
-                                gb->save();
-                                gb->reset();
-                            }
-                            break;
-                    }
-                }
-                break;
-                
-            case SDL_KEYUP:
-                if(e.key.repeat) break;
-
-                button = gb->getButton(e.key.keysym.sym);
-                if(button != Button::None)
-                {
-                    gb->release(button);
-                }
-                break;
+            return std::nullopt;
         }
+
+        u32 rgb = std::stoul(colour, nullptr, 16);
+        shade = { static_cast<u8>(rgb >> 16), static_cast<u8>(rgb >> 8), static_cast<u8>(rgb), UINT8_MAX };
     }
+
+    if(std::getline(ss, colour))
+    {
+        return std::nullopt;
+    }
+
+    return shades;
+}
+
+auto writeScreenshot(const std::string& path, const FrameExchange::Frame& frame) -> bool
+{
+    std::ofstream file(path, std::ios::binary);
+    if(!file)
+    {
+        return false;
+    }
+
+    // Binary PPM, which is just a header and the pixels without their alpha
+    file << "P6\n" << static_cast<u32>(SCREEN_WIDTH) << " " << static_cast<u32>(SCREEN_HEIGHT) << "\n255\n";
+    for(u32 pixel = 0; pixel < COLOUR_BUFFER_SIZE; ++pixel)
+    {
+        file.write(reinterpret_cast<const char*>(&frame[pixel * 4]), 3);
+    }
+
+    return static_cast<bool>(file);
 }
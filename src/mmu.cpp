@@ -2,15 +2,26 @@
 
 #include "mmu.hpp"
 
+#include "flags.hpp"
 #include "gameboy.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
 
 MMU::MMU(Gameboy& gb)
-    : m_Gameboy(gb), m_Memory({}), m_BootRom({}), m_BootRomEnabled(false)
+    : m_Gameboy(gb), m_Memory({}), m_VRAM({}), m_WRAM({}), m_VRAMOffset(0), m_WRAMOffset(WRAM_BANK_SIZE), m_CGB(false),
+      m_RomPages({}), m_OpenBus({}),
+      m_BootRom({}), m_BootRomEnabled(false),
+      m_PageFlags({}), m_FlaggedPages(0), m_SlowPath(false),
+      m_RTCMode(RTCMode::RealTime), m_DMAMode(DMAMode::Instant), m_DMAActive(false), m_DMAFromVRAM(false),
+      m_DMASource(0), m_DMAProgress(0), m_DMACycles(0),
+      m_HDMASource(0), m_HDMADest(0), m_HDMABlocks(0), m_HDMAActive(false)
 {
     DEBUG("Initializing MMU.");
+
+    m_OpenBus.fill(UINT8_MAX);
+    m_RomPages.fill(m_OpenBus.data());
 }
 
 void MMU::load(const std::string& path)
@@ -23,6 +34,8 @@ void MMU::load(const std::string& path)
     Cart::Type type   = MBC::getCartType(rom);
     std::string title = MBC::getCartTitle(rom);
 
+    m_CGB = MBC::isCartCGB(rom);
+
     m_Gameboy.setTitle("Shatter Emulator: " + title);
     DEBUG("Loaded " << title << ".");
 
@@ -41,11 +54,13 @@ void MMU::load(const std::string& path)
         case Cart::Type::MBC3:
         case Cart::Type::MBC3_RAM_2:
         case Cart::Type::MBC3_RAM_BATTERY_2:
-            m_Cart = std::make_unique<MBC3>(std::move(rom), std::move(ram));
+            m_Cart = std::make_unique<MBC3>(std::move(rom), std::move(ram), m_Gameboy.getTotalCycles(), m_RTCMode);
             break;
         default:
             m_Cart = std::make_unique<RomOnly>(std::move(rom));
     }
+
+    mapRom();
 }
 
 void MMU::loadBoot(const std::string& path)
@@ -54,11 +69,13 @@ void MMU::loadBoot(const std::string& path)
     std::ifstream data(path, std::ios::in | std::ios::binary);
     data.read(reinterpret_cast<char*>(&m_BootRom[0]), BOOT_ROM_SIZE);
     m_BootRomEnabled = true;
+
+    mapRom();
 }
 
 void MMU::save(const std::string& path)
 {
-    auto& ram = m_Cart->getRam();
+    std::vector<u8> ram = m_Cart->getSaveData();
 
     if(ram.empty())
     {
@@ -73,18 +90,40 @@ void MMU::save(const std::string& path)
 
 auto MMU::read(u16 address) const -> u8
 {
-    if(address < ROM_END_ADDR)
+    if(m_SlowPath) [[unlikely]]
     {
-        if(address < BOOT_ROM_SIZE && m_BootRomEnabled)
-        {
-            return m_BootRom[address];
-        }
+        return readSlow(address);
+    }
 
-        return m_Cart->read(address);
+    return readBus(address);
+}
+
+auto MMU::readSlow(u16 address) const -> u8
+{
+    if(m_DMAActive && isDMAConflict(address))
+    {
+        return UINT8_MAX;
+    }
+
+    u8 val = readBus(address);
+
+    if(m_PageFlags[address / PAGE_SIZE] & Flags::Page::WatchRead)
+    {
+        m_Gameboy.getDebugger().onWatch(address, val, false);
+    }
+
+    return val;
+}
+
+auto MMU::readBus(u16 address) const -> u8
+{
+    if(address < ROM_END_ADDR)
+    {
+        return m_RomPages[address / PAGE_SIZE][address % PAGE_SIZE];
     }
     else if(address < VRAM_END_ADDR)
     {
-        return m_Memory[address - ROM_SIZE];
+        return m_VRAM[m_VRAMOffset + address - VRAM_START_ADDR];
     }
     else if(address < RAM_BANK_END_ADDR)
     {
@@ -92,11 +131,11 @@ auto MMU::read(u16 address) const -> u8
     }
     else if(address < INTERNAL_RAM_END_ADDR)
     {
-        return m_Memory[address - ROM_SIZE];
+        return m_WRAM[getWRAMIndex(address)];
     }
     else if(address < ECHO_RAM_END_ADDR)
     {
-        return m_Memory[address - ROM_SIZE - INTERNAL_RAM_SIZE]; // Map back into RAM
+        return m_WRAM[getWRAMIndex(address - INTERNAL_RAM_SIZE)]; // Map back into RAM
     }
     else if(address < OAM_END_ADDR)
     {
@@ -114,6 +153,31 @@ auto MMU::read(u16 address) const -> u8
                 return m_Gameboy.getInput();
             case TIMER_DIV_REGISTER:
                 return m_Gameboy.getDIV();
+            case LCD_CONTROL_REGISTER:
+            case LCD_STAT_REGISTER:
+            case SCY_REGISTER:
+            case SCX_REGISTER:
+            case LY_REGISTER:
+            case LYC_REGISTER:
+            case BG_PALLETTE_REGISTER:
+            case OBJ_0_PALLETTE_REGISTER:
+            case OBJ_1_PALLETTE_REGISTER:
+            case WY_REGISTER:
+            case WX_REGISTER:
+                return m_Gameboy.readVideoRegister(address);
+            case SPEED_REGISTER:
+            case VRAM_BANK_REGISTER:
+            case HDMA_SOURCE_HI_REGISTER:
+            case HDMA_SOURCE_LO_REGISTER:
+            case HDMA_DEST_HI_REGISTER:
+            case HDMA_DEST_LO_REGISTER:
+            case HDMA_CONTROL_REGISTER:
+            case BG_PALETTE_INDEX_REGISTER:
+            case BG_PALETTE_DATA_REGISTER:
+            case OBJ_PALETTE_INDEX_REGISTER:
+            case OBJ_PALETTE_DATA_REGISTER:
+            case WRAM_BANK_REGISTER:
+                return m_CGB ? readCGBRegister(address) : m_Memory[address - ROM_SIZE];
             case BOOT_REGISTER:
                 return m_BootRomEnabled ? 0 : 1;
             default:
@@ -128,28 +192,50 @@ auto MMU::read(u16 address) const -> u8
 
 void MMU::write(u16 address, u8 val)
 {
+    if(m_SlowPath) [[unlikely]]
+    {
+        if(m_DMAActive && isDMAConflict(address))
+        {
+            return;
+        }
+
+        if(m_PageFlags[address / PAGE_SIZE] & Flags::Page::WatchWrite)
+        {
+            m_Gameboy.getDebugger().onWatch(address, val, true);
+        }
+    }
+
     if(address < ROM_END_ADDR)
     {
-        m_Cart->write(address, val);
+        // Only the switchable bank ever moves, so only its pages need looking up again
+        if(m_Cart->write(address, val)) [[unlikely]]
+        {
+            mapRomPages(ROM_BANK_OFFSET / PAGE_SIZE, ROM_END_ADDR / PAGE_SIZE);
+        }
     }
     else if(address < VRAM_END_ADDR)
     {
-        m_Memory[address - ROM_SIZE] = val;
+        m_DirtyMap.markVRAM(address + m_VRAMOffset);
+        m_VRAM[m_VRAMOffset + address - VRAM_START_ADDR] = val;
     }
     else if(address < RAM_BANK_END_ADDR)
     {
+        m_DirtyMap.markPage(address);
         m_Cart->write(address, val);
     }
     else if(address < INTERNAL_RAM_END_ADDR)
     {
-        m_Memory[address - ROM_SIZE] = val;
+        m_DirtyMap.markPage(address);
+        m_WRAM[getWRAMIndex(address)] = val;
     }
     else if(address < ECHO_RAM_END_ADDR)
     {
-        m_Memory[address - ROM_SIZE - INTERNAL_RAM_SIZE] = val; // Map back into RAM
+        m_DirtyMap.markPage(address - INTERNAL_RAM_SIZE);
+        m_WRAM[getWRAMIndex(address - INTERNAL_RAM_SIZE)] = val; // Map back into RAM
     }
     else if(address < OAM_END_ADDR)
     {
+        m_DirtyMap.markPage(address);
         m_Memory[address - ROM_SIZE] = val;
     }
     else if(address < UNUSABLE_END_ADDR)
@@ -158,6 +244,8 @@ void MMU::write(u16 address, u8 val)
     }
     else if(address < IO_END_ADDR)
     {
+        m_DirtyMap.markPage(address);
+
         switch(address)
         {
             case JOYPAD_REGISTER:
@@ -189,14 +277,51 @@ void MMU::write(u16 address, u8 val)
             case DMA_TRANSFER_REGISTER:
                 dmaTransfer(val);
                 break;
+            case LCD_CONTROL_REGISTER:
+            case LCD_STAT_REGISTER:
+            case SCY_REGISTER:
+            case SCX_REGISTER:
+            case LY_REGISTER:
+            case LYC_REGISTER:
+            case BG_PALLETTE_REGISTER:
+            case OBJ_0_PALLETTE_REGISTER:
+            case OBJ_1_PALLETTE_REGISTER:
+            case WY_REGISTER:
+            case WX_REGISTER:
+                m_Gameboy.writeVideoRegister(address, val);
+                break;
+            case SPEED_REGISTER:
+            case VRAM_BANK_REGISTER:
+            case HDMA_SOURCE_HI_REGISTER:
+            case HDMA_SOURCE_LO_REGISTER:
+            case HDMA_DEST_HI_REGISTER:
+            case HDMA_DEST_LO_REGISTER:
+            case HDMA_CONTROL_REGISTER:
+            case BG_PALETTE_INDEX_REGISTER:
+            case BG_PALETTE_DATA_REGISTER:
+            case OBJ_PALETTE_INDEX_REGISTER:
+            case OBJ_PALETTE_DATA_REGISTER:
+            case WRAM_BANK_REGISTER:
+                if(m_CGB)
+                {
+                    writeCGBRegister(address, val);
+                }
+                else
+                {
+                    m_Memory[address - ROM_SIZE] = val;
+                }
+                break;
             case BOOT_REGISTER:
                 m_BootRomEnabled = (val == 0);
+                mapRomPages(0, 1);
+                [[fallthrough]];
             default:
                 m_Memory[address - ROM_SIZE] = val;
         }
     }
     else
     {
+        m_DirtyMap.markPage(address);
         m_Memory[address - ROM_SIZE] = val;
     }
 }
@@ -206,11 +331,333 @@ auto MMU::isBootEnabled() const -> bool
     return m_BootRomEnabled;
 }
 
+auto MMU::isCGB() const -> bool
+{
+    return m_CGB;
+}
+
+void MMU::setDMAMode(DMAMode mode)
+{
+    m_DMAMode = mode;
+}
+
+void MMU::setRTCMode(RTCMode mode)
+{
+    m_RTCMode = mode;
+}
+
+void MMU::tickDMA(u8 cycles)
+{
+    if(!m_DMAActive) return;
+
+    m_DMACycles += cycles;
+
+    while(m_DMACycles >= CYCLES_PER_DMA_BYTE)
+    {
+        m_DMACycles -= CYCLES_PER_DMA_BYTE;
+        m_Memory[OAM_START_ADDR - ROM_SIZE + m_DMAProgress] = readBus(m_DMASource + m_DMAProgress);
+        m_DirtyMap.markPage(OAM_START_ADDR);
+
+        if(++m_DMAProgress == DMA_TRANSFER_SIZE)
+        {
+            m_DMAActive = false;
+            updateSlowPath();
+            break;
+        }
+    }
+}
+
+void MMU::stepHDMA()
+{
+    if(!m_HDMAActive) return;
+
+    copyHDMABlock();
+    m_Gameboy.stallCPU(CYCLES_PER_HDMA_BLOCK << m_Gameboy.isDoubleSpeed());
+
+    if(--m_HDMABlocks == 0)
+    {
+        m_HDMAActive = false;
+    }
+}
+
+auto MMU::getDirtyMap() -> DirtyMap&
+{
+    return m_DirtyMap;
+}
+
+auto MMU::getVRAM() const -> const u8*
+{
+    return m_VRAM.data();
+}
+
+auto MMU::getOAM() const -> const u8*
+{
+    return &m_Memory[OAM_START_ADDR - ROM_SIZE];
+}
+
+auto MMU::getRomBank() const -> u16
+{
+    return m_Cart ? m_Cart->getRomBank() : 1;
+}
+
+void MMU::setPageFlags(u8 page, u8 flags)
+{
+    if(m_PageFlags[page] == Flags::Page::PageNone && flags != Flags::Page::PageNone)
+    {
+        ++m_FlaggedPages;
+    }
+    else if(m_PageFlags[page] != Flags::Page::PageNone && flags == Flags::Page::PageNone)
+    {
+        --m_FlaggedPages;
+    }
+
+    m_PageFlags[page] = flags;
+    updateSlowPath();
+}
+
+void MMU::updateSlowPath()
+{
+    m_SlowPath = m_DMAActive || m_FlaggedPages > 0;
+}
+
+void MMU::mapRom(bool cheatsChanged)
+{
+    if(cheatsChanged)
+    {
+        m_PatchedPages.clear();
+    }
+
+    mapRomPages(0, m_RomPages.size());
+}
+
+void MMU::mapRomPages(u16 first, u16 last)
+{
+    if(!m_Cart) return;
+
+    const Cheats& cheats = m_Gameboy.getCheats();
+    u16 bank = m_Cart->getRomBank();
+
+    for(u16 page = first; page < last; ++page)
+    {
+        u16 address = page * PAGE_SIZE;
+
+        const u8* data = m_Cart->resolve(address);
+        if(!data)
+        {
+            data = m_OpenBus.data();
+        }
+
+        if(cheats.isPatched(page)) [[unlikely]]
+        {
+            // Patched pages are cached per bank, as the compare values may differ between banks
+            u32 key = (address < ROM_BANK_OFFSET ? 0 : (bank << 16)) | address;
+
+            auto it = m_PatchedPages.find(key);
+            if(it == m_PatchedPages.end())
+            {
+                std::array<u8, PAGE_SIZE> patched;
+                std::copy_n(data, PAGE_SIZE, patched.begin());
+                cheats.patch(address, patched);
+
+                it = m_PatchedPages.emplace(key, patched).first;
+            }
+
+            data = it->second.data();
+        }
+
+        m_RomPages[page] = data;
+    }
+
+    if(m_BootRomEnabled && first == 0)
+    {
+        m_RomPages[0] = m_BootRom.data();
+    }
+}
+
+auto MMU::resolve(u16 address) const -> const u8*
+{
+    if(address < ROM_END_ADDR)
+    {
+        return &m_RomPages[address / PAGE_SIZE][address % PAGE_SIZE];
+    }
+    else if(address < VRAM_END_ADDR)
+    {
+        return &m_VRAM[m_VRAMOffset + address - VRAM_START_ADDR];
+    }
+    else if(address < RAM_BANK_END_ADDR)
+    {
+        return m_Cart->resolve(address);
+    }
+    else if(address < INTERNAL_RAM_END_ADDR)
+    {
+        return &m_WRAM[getWRAMIndex(address)];
+    }
+
+    return nullptr;
+}
+
+auto MMU::getWRAMIndex(u16 address) const -> u32
+{
+    // 0xC000-0xCFFF is always bank 0, 0xD000-0xDFFF is whichever bank is mapped in (always 1 on DMG)
+    if(address < WRAM_BANK_START_ADDR)
+    {
+        return address - INTERNAL_RAM_START_ADDR;
+    }
+    return m_WRAMOffset + address - WRAM_BANK_START_ADDR;
+}
+
+auto MMU::readCGBRegister(u16 address) const -> u8
+{
+    switch(address)
+    {
+        case SPEED_REGISTER:
+            return m_Gameboy.getKEY1();
+        case VRAM_BANK_REGISTER:
+            return 0xFE | (m_VRAMOffset / VRAM_BANK_SIZE);
+        case HDMA_CONTROL_REGISTER:
+            // The blocks left, less one, with bit 7 clear while an HBlank transfer is running
+            return m_HDMAActive ? m_HDMABlocks - 1 : UINT8_MAX;
+        case WRAM_BANK_REGISTER:
+            return 0xF8 | (m_WRAMOffset / WRAM_BANK_SIZE);
+        case BG_PALETTE_INDEX_REGISTER:
+        case BG_PALETTE_DATA_REGISTER:
+        case OBJ_PALETTE_INDEX_REGISTER:
+        case OBJ_PALETTE_DATA_REGISTER:
+            return m_Gameboy.readVideoRegister(address);
+        default: // The HDMA addresses are write only
+            return UINT8_MAX;
+    }
+}
+
+void MMU::writeCGBRegister(u16 address, u8 val)
+{
+    switch(address)
+    {
+        case SPEED_REGISTER:
+            m_Gameboy.setKEY1(val);
+            break;
+        case VRAM_BANK_REGISTER:
+            m_VRAMOffset = (val & 0x01) * VRAM_BANK_SIZE;
+            break;
+        case HDMA_SOURCE_HI_REGISTER:
+            m_HDMASource = (m_HDMASource & 0x00FF) | (val << 8);
+            break;
+        case HDMA_SOURCE_LO_REGISTER:
+            m_HDMASource = (m_HDMASource & 0xFF00) | (val & 0xF0);
+            break;
+        case HDMA_DEST_HI_REGISTER: // Always somewhere in VRAM
+            m_HDMADest = (m_HDMADest & 0x00FF) | ((val & 0x1F) << 8);
+            break;
+        case HDMA_DEST_LO_REGISTER:
+            m_HDMADest = (m_HDMADest & 0xFF00) | (val & 0xF0);
+            break;
+        case HDMA_CONTROL_REGISTER:
+        {
+            u8 blocks = (val & 0x7F) + 1;
+
+            if(bit_functions::get_bit(val, 7))
+            {
+                m_HDMABlocks = blocks;
+                m_HDMAActive = true;
+            }
+            else if(m_HDMAActive) // Writing with bit 7 clear stops an HBlank transfer
+            {
+                m_HDMAActive = false;
+            }
+            else
+            {
+                for(u8 i = 0; i < blocks; ++i)
+                {
+                    copyHDMABlock();
+                }
+                m_Gameboy.stallCPU((blocks * CYCLES_PER_HDMA_BLOCK) << m_Gameboy.isDoubleSpeed());
+            }
+            break;
+        }
+        case WRAM_BANK_REGISTER: // Bank 0 can't be mapped in twice, so it maps bank 1 instead
+            m_WRAMOffset = std::max(val & 0x07, 1) * WRAM_BANK_SIZE;
+            break;
+        case BG_PALETTE_INDEX_REGISTER:
+        case BG_PALETTE_DATA_REGISTER:
+        case OBJ_PALETTE_INDEX_REGISTER:
+        case OBJ_PALETTE_DATA_REGISTER:
+            m_Gameboy.writeVideoRegister(address, val);
+            break;
+        default:
+            ASSERT(false, "Invalid CGB register!");
+    }
+}
+
+void MMU::copyHDMABlock()
+{
+    u16 dest = m_VRAMOffset + (m_HDMADest & (VRAM_BANK_SIZE - 1));
+    u8* to   = &m_VRAM[dest];
+
+    // A block never crosses a bank or page boundary, so it can be copied straight from whatever backs it
+    if(const u8* from = resolve(m_HDMASource))
+    {
+        std::copy_n(from, HDMA_BLOCK_SIZE, to);
+    }
+    else
+    {
+        for(u8 i = 0; i < HDMA_BLOCK_SIZE; ++i)
+        {
+            to[i] = readBus(m_HDMASource + i);
+        }
+    }
+
+    m_DirtyMap.markVRAM(VRAM_START_ADDR + dest);
+
+    m_HDMASource += HDMA_BLOCK_SIZE;
+    m_HDMADest   += HDMA_BLOCK_SIZE;
+}
+
+auto MMU::isDMAConflict(u16 address) const -> bool
+{
+    // OAM is always in use, while IO and HRAM are never on the DMA's bus
+    if(address >= OAM_START_ADDR)
+    {
+        return address < OAM_END_ADDR;
+    }
+
+    // Otherwise only the bus being copied from (VRAM or external) is blocked
+    bool vram = address >= VRAM_START_ADDR && address < VRAM_END_ADDR;
+    return vram == m_DMAFromVRAM;
+}
+
 void MMU::dmaTransfer(u8 val)
 {
-    u16 address = val * 0x100;
-    for (u8 i = 0; i < DMA_TRANSFER_SIZE; ++i)
+    u16 source = val * 0x100;
+
+    // Sources past internal ram read from echo ram, which maps back into ram
+    if(source >= ECHO_RAM_START_ADDR)
+    {
+        source -= INTERNAL_RAM_SIZE;
+    }
+
+    if(m_DMAMode == DMAMode::Timed)
+    {
+        m_DMAActive   = true;
+        m_DMAFromVRAM = source >= VRAM_START_ADDR && source < VRAM_END_ADDR;
+        m_DMASource   = source;
+        m_DMAProgress = 0;
+        m_DMACycles   = 0;
+        updateSlowPath();
+        return;
+    }
+
+    u8* oam = &m_Memory[OAM_START_ADDR - ROM_SIZE];
+    m_DirtyMap.markPage(OAM_START_ADDR);
+
+    if(const u8* data = resolve(source))
+    {
+        std::copy_n(data, DMA_TRANSFER_SIZE, oam);
+        return;
+    }
+
+    // Not backed by plain memory (i.e. an RTC register), so fall back to the bus
+    for(u8 i = 0; i < DMA_TRANSFER_SIZE; ++i)
     {
-        write(OAM_START_ADDR + i, read(address + i));
+        oam[i] = readBus(source + i);
     }
 }
@@ -3,14 +3,39 @@
 #include "core.hpp"
 
 #include <array>
+#include <map>
 #include <memory>
 
 #include "cart/romonly.hpp"
 #include "cart/mbc1.hpp"
 #include "cart/mbc3.hpp"
 
+#include "dirty_map.hpp"
+
 class Gameboy;
 
+/**
+    Instant DMA copies all of OAM the moment 0xFF46 is written.
+    Timed DMA copies a byte every M-cycle, and locks the CPU out
+    of the bus it is copying from (and OAM) until it is done.
+
+    https://gbdev.io/pandocs/OAM_DMA_Transfer.html
+
+    In CGB mode HDMA copies to VRAM in 16 byte blocks, each resolved
+    to the memory behind it and copied in one go. A general purpose
+    transfer copies everything as soon as it's started, while an HBlank
+    transfer copies a block at the start of each HBlank. The CPU is
+    stalled for as long as the hardware would take over each copy.
+
+    https://gbdev.io/pandocs/CGB_Registers.html
+**/
+
+enum class DMAMode
+{
+    Instant,
+    Timed
+};
+
 class MMU
 {
     public:
@@ -59,7 +84,163 @@ class MMU
          * @return The status of if the bootrom is enabled
          */
         [[nodiscard]] auto isBootEnabled() const -> bool;
+
+        /**
+         * @brief Checks if the loaded cart runs in CGB mode
+         * 
+         */
+        [[nodiscard]] auto isCGB() const -> bool;
+
+        /**
+         * @brief Sets how OAM DMA transfers are performed
+         * 
+         * @param mode The DMA mode to use
+         */
+        void setDMAMode(DMAMode mode);
+
+        /**
+         * @brief Sets what the cartridge's real time clock follows,
+         * which takes effect on the next load
+         * 
+         * @param mode The RTC mode to use
+         */
+        void setRTCMode(RTCMode mode);
+
+        /**
+         * @brief Advances a timed DMA transfer by the elapsed number of cycles
+         * 
+         * @param cycles The number of cycles since the last update
+         */
+        void tickDMA(u8 cycles);
+
+        /**
+         * @brief Copies the next block of an HBlank HDMA transfer,
+         * if one is running, as HBlank starts
+         * 
+         */
+        void stepHDMA();
+
+        /**
+         * @brief Gets the map of which memory has been written to
+         * 
+         */
+        [[nodiscard]] auto getDirtyMap() -> DirtyMap&;
+
+        /**
+         * @brief Gets VRAM, for the PPU to read directly
+         * 
+         * @return A pointer to 0x8000 of bank 0, which bank 1 follows
+         */
+        [[nodiscard]] auto getVRAM() const -> const u8*;
+
+        /**
+         * @brief Gets OAM, for the PPU to read directly
+         * 
+         * @return A pointer to 0xFE00
+         */
+        [[nodiscard]] auto getOAM() const -> const u8*;
+
+        /**
+         * @brief Gets the rom bank currently mapped to 0x4000-0x7FFF
+         * 
+         */
+        [[nodiscard]] auto getRomBank() const -> u16;
+
+        /**
+         * @brief Sets the flags of a page, anything other than Flags::Page::PageNone
+         * moves every access to that page onto the slow path
+         * 
+         * @param page The page (high byte of the address) to set the flags of
+         * @param flags The flags to set
+         */
+        void setPageFlags(u8 page, u8 flags);
+
+        /**
+         * @brief Rebuilds the rom page table, after a bank switch or
+         * a change to the cheats
+         * 
+         * @param cheatsChanged If patched pages need to be rebuilt
+         */
+        void mapRom(bool cheatsChanged = false);
     private:
+        /**
+         * @brief Reads a byte while a DMA is running or a page is flagged
+         * 
+         * @param address The address to read from
+         * @return The value stored at that address
+         */
+        [[nodiscard]] auto readSlow(u16 address) const -> u8;
+
+        /**
+         * @brief Looks up the memory behind part of the rom page table again
+         * 
+         * @param first The first page to map
+         * @param last The page after the last one to map
+         */
+        void mapRomPages(u16 first, u16 last);
+
+        /**
+         * @brief Updates if accesses need to go through the slow path
+         * 
+         */
+        void updateSlowPath();
+
+        /**
+         * @brief Gets where an internal ram address is in the banked ram
+         * 
+         * @param address The address, between 0xC000 and 0xDFFF
+         * @return The index into the banked ram
+         */
+        [[nodiscard]] auto getWRAMIndex(u16 address) const -> u32;
+
+        /**
+         * @brief Reads one of the registers only there in CGB mode
+         * 
+         * @param address The register's address
+         * @return The register's value
+         */
+        [[nodiscard]] auto readCGBRegister(u16 address) const -> u8;
+
+        /**
+         * @brief Writes one of the registers only there in CGB mode
+         * 
+         * @param address The register's address
+         * 
+         * @param val The value to write
+         */
+        void writeCGBRegister(u16 address, u8 val);
+
+        /**
+         * @brief Copies the next 16 bytes of an HDMA transfer into VRAM
+         * 
+         */
+        void copyHDMABlock();
+
+        /**
+         * @brief Reads a byte from the bus, ignoring any DMA conflicts
+         * 
+         * @param address The address to read from
+         * @return The value stored at that address
+         */
+        [[nodiscard]] auto readBus(u16 address) const -> u8;
+
+        /**
+         * @brief Resolves an address to the memory backing it, for block copies
+         * 
+         * @param address The address to resolve
+         * @return A pointer to the byte at that address, or nullptr if the
+         * address isn't backed by plain memory
+         */
+        [[nodiscard]] auto resolve(u16 address) const -> const u8*;
+
+        /**
+         * @brief Checks if the CPU is locked out of an address by a running DMA
+         * 
+         * @param address The address being accessed
+         * @return If the access conflicts with the DMA transfer
+         */
+        [[nodiscard]] auto isDMAConflict(u16 address) const -> bool;
+
         /**
          * @brief Initiates the DMA transfer
          * 
@@ -70,8 +251,37 @@ class MMU
         Gameboy& m_Gameboy;
         
         std::unique_ptr<MBC> m_Cart;
-        std::array<u8, RAM_SIZE> m_Memory;
+        std::array<u8, RAM_SIZE> m_Memory; // VRAM and internal ram are banked, so they're kept apart
+        DirtyMap m_DirtyMap;
+
+        std::array<u8, VRAM_BANK_COUNT * VRAM_BANK_SIZE> m_VRAM;
+        std::array<u8, WRAM_BANK_COUNT * WRAM_BANK_SIZE> m_WRAM;
+        u32 m_VRAMOffset; // Where the banks mapped in start
+        u32 m_WRAMOffset;
+        bool m_CGB;
+
+        std::array<const u8*, ROM_END_ADDR / PAGE_SIZE> m_RomPages;
+        std::map<u32, std::array<u8, PAGE_SIZE>> m_PatchedPages;
+        std::array<u8, PAGE_SIZE> m_OpenBus;
 
         std::array<u8, BOOT_ROM_SIZE> m_BootRom;
         bool m_BootRomEnabled;
+
+        std::array<u8, PAGE_COUNT> m_PageFlags;
+        u16 m_FlaggedPages;
+        bool m_SlowPath;
+
+        RTCMode m_RTCMode;
+
+        DMAMode m_DMAMode;
+        bool m_DMAActive;
+        bool m_DMAFromVRAM;
+        u16 m_DMASource;
+        u8  m_DMAProgress;
+        u16 m_DMACycles;
+
+        u16 m_HDMASource;
+        u16 m_HDMADest;
+        u8  m_HDMABlocks;
+        bool m_HDMAActive; // An HBlank transfer is waiting for the next HBlank
 };
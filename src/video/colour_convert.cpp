@@ -0,0 +1,186 @@
+#include "core.hpp"
+
+#include "colour_convert.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define HAS_X86_SIMD
+#endif
+
+namespace Colour
+{
+    template <typename Table>
+    static void toRGBAScalar(const GBColour* indices, u8* rgba, u32 count, const Table& palette)
+    {
+        for(u32 i = 0; i < count; ++i)
+        {
+            std::memcpy(rgba + i * 4, &palette[indices[i]], sizeof(u32));
+        }
+    }
+
+    #ifdef HAS_X86_SIMD
+
+    __attribute__((target("ssse3")))
+    static void toRGBASSSE3(const GBColour* indices, u8* rgba, u32 count, const Palette& palette)
+    {
+        // Split the palette into a 16 byte table per channel, so each can be looked up with a byte shuffle
+        alignas(16) std::array<std::array<u8, 16>, 4> channels;
+        for(u8 i = 0; i < palette.size(); ++i)
+        {
+            for(u8 channel = 0; channel < channels.size(); ++channel)
+            {
+                channels[channel][i] = reinterpret_cast<const u8*>(&palette[i])[channel];
+            }
+        }
+
+        const __m128i red   = _mm_load_si128(reinterpret_cast<const __m128i*>(channels[0].data()));
+        const __m128i green = _mm_load_si128(reinterpret_cast<const __m128i*>(channels[1].data()));
+        const __m128i blue  = _mm_load_si128(reinterpret_cast<const __m128i*>(channels[2].data()));
+        const __m128i alpha = _mm_load_si128(reinterpret_cast<const __m128i*>(channels[3].data()));
+
+        u32 i = 0;
+        for(; i + 16 <= count; i += 16)
+        {
+            __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+
+            __m128i r = _mm_shuffle_epi8(red,   lanes);
+            __m128i g = _mm_shuffle_epi8(green, lanes);
+            __m128i b = _mm_shuffle_epi8(blue,  lanes);
+            __m128i a = _mm_shuffle_epi8(alpha, lanes);
+
+            // Interleave the channels back into pixels
+            __m128i rgLow  = _mm_unpacklo_epi8(r, g);
+            __m128i rgHigh = _mm_unpackhi_epi8(r, g);
+            __m128i baLow  = _mm_unpacklo_epi8(b, a);
+            __m128i baHigh = _mm_unpackhi_epi8(b, a);
+
+            __m128i* out = reinterpret_cast<__m128i*>(rgba + i * 4);
+            _mm_storeu_si128(out,     _mm_unpacklo_epi16(rgLow,  baLow ));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rgLow,  baLow ));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rgHigh, baHigh));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rgHigh, baHigh));
+        }
+
+        toRGBAScalar(indices + i, rgba + i * 4, count - i, palette);
+    }
+
+    __attribute__((target("avx2")))
+    static void toRGBAAVX2(const GBColour* indices, u8* rgba, u32 count, const Palette& palette)
+    {
+        // A lane permute only reaches 8 entries, so look up both halves of the table and pick with bit 3
+        const __m256i low  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(palette.data()));
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(palette.data() + 8));
+
+        u32 i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + i)));
+
+            __m256 fromLow  = _mm256_castsi256_ps(_mm256_permutevar8x32_epi32(low,  lanes));
+            __m256 fromHigh = _mm256_castsi256_ps(_mm256_permutevar8x32_epi32(high, lanes));
+            __m256 useHigh  = _mm256_castsi256_ps(_mm256_slli_epi32(lanes, 28));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i * 4), _mm256_castps_si256(_mm256_blendv_ps(fromLow, fromHigh, useHigh)));
+        }
+
+        toRGBAScalar(indices + i, rgba + i * 4, count - i, palette);
+    }
+
+    __attribute__((target("avx2")))
+    static void toRGBAAVX2(const GBColour* indices, u8* rgba, u32 count, const CGBPalette& palette)
+    {
+        // 64 entries are too many to permute through, so gather them
+        const int* table = reinterpret_cast<const int*>(palette.data());
+
+        u32 i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + i)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i * 4), _mm256_i32gather_epi32(table, lanes, sizeof(u32)));
+        }
+
+        toRGBAScalar(indices + i, rgba + i * 4, count - i, palette);
+    }
+
+    #endif
+
+    auto toPixel(ScreenColour colour) -> u32
+    {
+        u32 pixel;
+        std::memcpy(&pixel, &colour, sizeof(pixel));
+        return pixel;
+    }
+
+    auto isConvertPathSupported(ConvertPath path) -> bool
+    {
+        switch(path)
+        {
+            case ConvertPath::Scalar:
+                return true;
+            #ifdef HAS_X86_SIMD
+            case ConvertPath::SSSE3:
+                return __builtin_cpu_supports("ssse3");
+            case ConvertPath::AVX2:
+                return __builtin_cpu_supports("avx2");
+            #endif
+            default:
+                return false;
+        }
+    }
+
+    auto getBestConvertPath() -> ConvertPath
+    {
+        static const ConvertPath best = []
+        {
+            for(ConvertPath path : {ConvertPath::AVX2, ConvertPath::SSSE3})
+            {
+                if(isConvertPathSupported(path)) return path;
+            }
+            return ConvertPath::Scalar;
+        }();
+
+        return best;
+    }
+
+    void toRGBA(const GBColour* indices, u8* rgba, u32 count, const Palette& palette)
+    {
+        toRGBA(indices, rgba, count, palette, getBestConvertPath());
+    }
+
+    void toRGBA(const GBColour* indices, u8* rgba, u32 count, const Palette& palette, ConvertPath path)
+    {
+        if(!isConvertPathSupported(path))
+        {
+            path = ConvertPath::Scalar;
+        }
+
+        switch(path)
+        {
+            #ifdef HAS_X86_SIMD
+            case ConvertPath::SSSE3:
+                toRGBASSSE3(indices, rgba, count, palette);
+                break;
+            case ConvertPath::AVX2:
+                toRGBAAVX2(indices, rgba, count, palette);
+                break;
+            #endif
+            default:
+                toRGBAScalar(indices, rgba, count, palette);
+        }
+    }
+
+    void toRGBA(const GBColour* indices, u8* rgba, u32 count, const CGBPalette& palette)
+    {
+        #ifdef HAS_X86_SIMD
+        if(getBestConvertPath() == ConvertPath::AVX2)
+        {
+            toRGBAAVX2(indices, rgba, count, palette);
+            return;
+        }
+        #endif
+
+        toRGBAScalar(indices, rgba, count, palette);
+    }
+}
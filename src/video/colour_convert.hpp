@@ -0,0 +1,107 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+
+#include "video_defs.hpp"
+
+/**
+    Converts a buffer of colour indices into RGBA pixels through a
+    16 entry table, which holds all three palettes, indexed by a colour
+    index tagged with its palette (see Colour::tag). This runs over
+    each line once it's finished, so the scanline renderer only ever
+    has to deal with indices.
+
+    On x86 there are SSSE3 and AVX2 paths, picked at runtime when the
+    CPU supports them. Anything else gets the scalar path.
+
+    CGB lines go through a 64 entry table instead, one for each colour
+    of the 16 CGB palettes, which only has a scalar and an AVX2 path,
+    as it's too big to look up with byte shuffles.
+**/
+
+namespace Colour
+{
+    /**
+     * @brief RGBA colours as 32 bit pixels, in the same byte order as the frame buffer,
+     * for each tagged colour index
+     */
+    using Palette = std::array<u32, 16>;
+
+    /**
+     * @brief RGBA colours as 32 bit pixels for each CGB tagged colour index,
+     * the 8 background palettes followed by the 8 object palettes
+     */
+    using CGBPalette = std::array<u32, 64>;
+
+    enum class ConvertPath
+    {
+        Scalar,
+        SSSE3,
+        AVX2
+    };
+
+    /**
+     * @brief Packs a screen colour into a pixel, as stored in the frame buffer
+     * 
+     * @param colour The colour to pack
+     * @return The packed pixel
+     */
+    [[nodiscard]] auto toPixel(ScreenColour colour) -> u32;
+
+    /**
+     * @brief Gets the fastest conversion path the CPU supports
+     * 
+     */
+    [[nodiscard]] auto getBestConvertPath() -> ConvertPath;
+
+    /**
+     * @brief Checks if the CPU can run a conversion path
+     * 
+     * @param path The path to check
+     */
+    [[nodiscard]] auto isConvertPathSupported(ConvertPath path) -> bool;
+
+    /**
+     * @brief Converts colour indices into RGBA pixels using the fastest path available
+     * 
+     * @param indices The colour indices to convert
+     * 
+     * @param rgba The buffer to write the pixels to, 4 bytes per index
+     * 
+     * @param count The number of indices to convert
+     * 
+     * @param palette The pixel for each tagged colour index
+     */
+    void toRGBA(const GBColour* indices, u8* rgba, u32 count, const Palette& palette);
+
+    /**
+     * @brief Converts colour indices into RGBA pixels using a given path,
+     * falling back to the scalar path if the CPU doesn't support it
+     * 
+     * @param indices The colour indices to convert
+     * 
+     * @param rgba The buffer to write the pixels to, 4 bytes per index
+     * 
+     * @param count The number of indices to convert
+     * 
+     * @param palette The pixel for each tagged colour index
+     * 
+     * @param path The conversion path to use
+     */
+    void toRGBA(const GBColour* indices, u8* rgba, u32 count, const Palette& palette, ConvertPath path);
+
+    /**
+     * @brief Converts CGB colour indices into RGBA pixels using the fastest path available
+     * 
+     * @param indices The colour indices to convert
+     * 
+     * @param rgba The buffer to write the pixels to, 4 bytes per index
+     * 
+     * @param count The number of indices to convert
+     * 
+     * @param palette The pixel for each CGB tagged colour index
+     */
+    void toRGBA(const GBColour* indices, u8* rgba, u32 count, const CGBPalette& palette);
+}
@@ -0,0 +1,49 @@
+#include "core.hpp"
+
+#include "frame_exchange.hpp"
+
+FrameExchange::FrameExchange()
+    : m_Buffers({}), m_Versions({}), m_Version(0), m_Back(0), m_Front(1), m_Middle(2), m_FrontUnchanged(false), m_FrameCount(0) {}
+
+void FrameExchange::publish(bool changed)
+{
+    // The version travels with the buffer, so the consumer compares whatever frames it actually got
+    if(changed)
+    {
+        m_Version++;
+    }
+    m_Versions[m_Back] = m_Version;
+
+    // Release so the consumer sees everything drawn into the buffer before it sees the swap
+    m_Back = m_Middle.exchange(m_Back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    m_FrameCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto FrameExchange::acquire() -> const Frame*
+{
+    if(!(m_Middle.load(std::memory_order_relaxed) & FRESH_BIT))
+    {
+        return nullptr;
+    }
+
+    u64 previous = m_Versions[m_Front];
+
+    m_Front = m_Middle.exchange(m_Front, std::memory_order_acq_rel) & INDEX_MASK;
+    m_FrontUnchanged = m_Versions[m_Front] == previous;
+    return &m_Buffers[m_Front];
+}
+
+auto FrameExchange::getFrontBuffer() const -> const Frame&
+{
+    return m_Buffers[m_Front];
+}
+
+auto FrameExchange::isFrontUnchanged() const -> bool
+{
+    return m_FrontUnchanged;
+}
+
+auto FrameExchange::getFrameCount() const -> u64
+{
+    return m_FrameCount.load(std::memory_order_relaxed);
+}
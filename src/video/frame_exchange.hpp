@@ -0,0 +1,111 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+#include <atomic>
+
+/**
+    Hands finished frames from the PPU to whoever displays them,
+    without copying and without either side waiting on the other.
+
+    There are three buffers. The PPU draws into the back buffer, and
+    publishing swaps it with the middle one. The consumer takes the
+    middle buffer in exchange for the one it last displayed whenever
+    a newer frame has been published, so it always gets the newest
+    complete frame, and frames it was too slow for are dropped.
+
+    The producer says whether each frame differs from the one before,
+    so the consumer can tell when the frame it takes looks the same as
+    the one it already has, and skip presenting it again.
+
+    One producer and one consumer, which may be on different threads.
+**/
+
+class FrameExchange
+{
+    public:
+        using Frame = std::array<u8, FRAME_BUFFER_SIZE>;
+
+        static constexpr u8 BUFFER_COUNT = 3;
+    public:
+        FrameExchange();
+
+        /**
+         * @brief Gets the buffer the producer is drawing into
+         * 
+         */
+        [[nodiscard]] __always_inline auto getBackBuffer() -> Frame&;
+
+        /**
+         * @brief Gets which of the buffers is the back buffer, so the
+         * producer can remember what it last drew into each one
+         * 
+         */
+        [[nodiscard]] __always_inline auto getBackIndex() const -> u8;
+
+        /**
+         * @brief Publishes the back buffer as the newest complete frame,
+         * and gives the producer a new buffer to draw into
+         * 
+         * @param changed Whether the frame differs from the last one published
+         */
+        void publish(bool changed = true);
+
+        /**
+         * @brief Takes the newest complete frame, if one has been
+         * published since the last call
+         * 
+         * @return The frame, which stays valid until the next call,
+         * or nullptr if there's nothing new
+         */
+        [[nodiscard]] auto acquire() -> const Frame*;
+
+        /**
+         * @brief Gets the frame the consumer last acquired
+         * 
+         */
+        [[nodiscard]] auto getFrontBuffer() const -> const Frame&;
+
+        /**
+         * @brief Checks if the frame last acquired looks the same as
+         * the one acquired before it
+         * 
+         */
+        [[nodiscard]] auto isFrontUnchanged() const -> bool;
+
+        /**
+         * @brief Gets the number of frames published so far
+         * 
+         */
+        [[nodiscard]] auto getFrameCount() const -> u64;
+    private:
+        // The middle buffer's index, with this bit set while it holds a frame the consumer hasn't taken
+        static constexpr u8 FRESH_BIT = 0b100;
+        static constexpr u8 INDEX_MASK = 0b011;
+
+        std::array<Frame, BUFFER_COUNT> m_Buffers;
+
+        // Which version of the picture each buffer holds, bumped whenever a published frame changed
+        std::array<u64, BUFFER_COUNT> m_Versions;
+        u64 m_Version;
+
+        u8 m_Back;
+        u8 m_Front;
+        std::atomic<u8> m_Middle;
+        bool m_FrontUnchanged;
+
+        std::atomic<u64> m_FrameCount;
+};
+
+//--------------------------  Inline function implementations --------------------------//
+
+__always_inline auto FrameExchange::getBackBuffer() -> Frame&
+{
+    return m_Buffers[m_Back];
+}
+
+__always_inline auto FrameExchange::getBackIndex() const -> u8
+{
+    return m_Back;
+}
@@ -0,0 +1,337 @@
+#include "core.hpp"
+
+#include "frame_hash.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define HAS_X86_SIMD
+#endif
+
+namespace FrameHash
+{
+    static constexpr u32 STRIPE_SIZE = 32;
+    static constexpr u32 LANES       = STRIPE_SIZE / sizeof(u64);
+
+    // The key each lane starts with, and what's added to it every stripe
+    alignas(32) static constexpr std::array<u64, LANES> KEYS  = { 0x9E3779B185EBCA87, 0xC2B2AE3D27D4EB4F, 0x165667B19E3779F9, 0x85EBCA77C2B2AE63 };
+    alignas(32) static constexpr std::array<u64, LANES> STEPS = { 0x27D4EB2F165667C5, 0x94D049BB133111EB, 0xBF58476D1CE4E5B9, 0x9E3779B97F4A7C15 };
+
+    static constexpr char MAGIC[4] = { 'S', 'H', 'F', 'H' };
+
+    using Lanes = std::array<u64, LANES>;
+
+    static __always_inline auto mix(u64 value) -> u64
+    {
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCD;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53;
+        value ^= value >> 33;
+        return value;
+    }
+
+    static void accumulateScalar(Lanes& accumulators, Lanes& keys, const u8* data, u32 stripes)
+    {
+        for(u32 stripe = 0; stripe < stripes; ++stripe, data += STRIPE_SIZE)
+        {
+            for(u32 lane = 0; lane < LANES; ++lane)
+            {
+                u64 value;
+                std::memcpy(&value, data + lane * sizeof(u64), sizeof(value));
+
+                u64 keyed = value ^ keys[lane];
+                accumulators[lane] += (keyed & UINT32_MAX) * (keyed >> 32) + value;
+                keys[lane] += STEPS[lane];
+            }
+        }
+    }
+
+    #ifdef HAS_X86_SIMD
+
+    __attribute__((target("sse2")))
+    static void accumulateSSE2(Lanes& accumulators, Lanes& keys, const u8* data, u32 stripes)
+    {
+        // Lanes 0 and 1 in one register, 2 and 3 in the other
+        __m128i low     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulators.data()));
+        __m128i high    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulators.data() + 2));
+        __m128i keyLow  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys.data()));
+        __m128i keyHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys.data() + 2));
+
+        const __m128i stepLow  = _mm_load_si128(reinterpret_cast<const __m128i*>(STEPS.data()));
+        const __m128i stepHigh = _mm_load_si128(reinterpret_cast<const __m128i*>(STEPS.data() + 2));
+
+        for(u32 stripe = 0; stripe < stripes; ++stripe, data += STRIPE_SIZE)
+        {
+            __m128i valueLow  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            __m128i valueHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+
+            // Multiplying the low half of each lane by its high half
+            __m128i keyedLow  = _mm_xor_si128(valueLow,  keyLow);
+            __m128i keyedHigh = _mm_xor_si128(valueHigh, keyHigh);
+            low  = _mm_add_epi64(low,  _mm_add_epi64(_mm_mul_epu32(keyedLow,  _mm_srli_epi64(keyedLow,  32)), valueLow));
+            high = _mm_add_epi64(high, _mm_add_epi64(_mm_mul_epu32(keyedHigh, _mm_srli_epi64(keyedHigh, 32)), valueHigh));
+
+            keyLow  = _mm_add_epi64(keyLow,  stepLow);
+            keyHigh = _mm_add_epi64(keyHigh, stepHigh);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulators.data()),     low);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulators.data() + 2), high);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(keys.data()),             keyLow);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(keys.data() + 2),         keyHigh);
+    }
+
+    __attribute__((target("avx2")))
+    static void accumulateAVX2(Lanes& accumulators, Lanes& keys, const u8* data, u32 stripes)
+    {
+        // A whole stripe at a time
+        __m256i accumulator = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulators.data()));
+        __m256i key         = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys.data()));
+        const __m256i step  = _mm256_load_si256(reinterpret_cast<const __m256i*>(STEPS.data()));
+
+        for(u32 stripe = 0; stripe < stripes; ++stripe, data += STRIPE_SIZE)
+        {
+            __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            __m256i keyed = _mm256_xor_si256(value, key);
+
+            accumulator = _mm256_add_epi64(accumulator, _mm256_add_epi64(_mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32)), value));
+            key = _mm256_add_epi64(key, step);
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulators.data()), accumulator);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(keys.data()), key);
+    }
+
+    #endif
+
+    auto isHashPathSupported(HashPath path) -> bool
+    {
+        switch(path)
+        {
+            case HashPath::Scalar:
+                return true;
+            #ifdef HAS_X86_SIMD
+            case HashPath::SSE2:
+                return __builtin_cpu_supports("sse2");
+            case HashPath::AVX2:
+                return __builtin_cpu_supports("avx2");
+            #endif
+            default:
+                return false;
+        }
+    }
+
+    static auto getBestHashPath() -> HashPath
+    {
+        static const HashPath best = []
+        {
+            for(HashPath path : {HashPath::AVX2, HashPath::SSE2})
+            {
+                if(isHashPathSupported(path)) return path;
+            }
+            return HashPath::Scalar;
+        }();
+
+        return best;
+    }
+
+    auto hash(const u8* data, u32 size, u64 seed) -> u64
+    {
+        return hash(data, size, seed, getBestHashPath());
+    }
+
+    auto hash(const u8* data, u32 size, u64 seed, HashPath path) -> u64
+    {
+        if(!isHashPathSupported(path))
+        {
+            path = HashPath::Scalar;
+        }
+
+        Lanes accumulators = { seed, seed, seed, seed };
+        Lanes keys = KEYS;
+
+        auto accumulate = [&](const u8* stripes, u32 count)
+        {
+            switch(path)
+            {
+                #ifdef HAS_X86_SIMD
+                case HashPath::SSE2:
+                    accumulateSSE2(accumulators, keys, stripes, count);
+                    break;
+                case HashPath::AVX2:
+                    accumulateAVX2(accumulators, keys, stripes, count);
+                    break;
+                #endif
+                default:
+                    accumulateScalar(accumulators, keys, stripes, count);
+                    break;
+            }
+        };
+
+        accumulate(data, size / STRIPE_SIZE);
+
+        // Whatever's left over is padded out to a stripe with zeros
+        if(u32 remaining = size % STRIPE_SIZE; remaining != 0)
+        {
+            std::array<u8, STRIPE_SIZE> last {};
+            std::memcpy(last.data(), data + size - remaining, remaining);
+            accumulate(last.data(), 1);
+        }
+
+        // Fold the lanes together in order, so they can't stand in for each other
+        u64 result = mix(seed ^ (size * KEYS[0]));
+        for(u64 accumulator : accumulators)
+        {
+            result = mix(result + accumulator);
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Parses a whole CSV field as a number
+     * 
+     * @param text The field
+     * @param base The base the number is written in
+     * @param value Where to put the number
+     * @return If the field was a number that fits in 64 bits
+     */
+    static auto parseField(const std::string& text, int base, u64& value) -> bool
+    {
+        u32 maxDigits = (base == 16) ? 16 : 20;
+        if(text.empty() || text.size() > maxDigits)
+        {
+            return false;
+        }
+
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+        return error == std::errc() && end == text.data() + text.size();
+    }
+
+    auto readStream(const std::string& path) -> std::optional<std::vector<Record>>
+    {
+        std::ifstream file(path, std::ios::binary);
+        if(!file)
+        {
+            return std::nullopt;
+        }
+
+        std::vector<Record> records;
+
+        char magic[sizeof(MAGIC)] = {};
+        file.read(magic, sizeof(magic));
+
+        if(file.gcount() == sizeof(MAGIC) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0)
+        {
+            std::array<u8, sizeof(u32) + sizeof(u64)> record;
+            while(file.read(reinterpret_cast<char*>(record.data()), record.size()))
+            {
+                u32 frame = 0;
+                u64 hash  = 0;
+                for(u32 byte = 0; byte < sizeof(u32); ++byte) frame |= static_cast<u32>(record[byte]) << (byte * 8);
+                for(u32 byte = 0; byte < sizeof(u64); ++byte) hash  |= static_cast<u64>(record[sizeof(u32) + byte]) << (byte * 8);
+
+                records.push_back({ frame, hash });
+            }
+
+            return records;
+        }
+
+        // Otherwise it's CSV, with a header line
+        file.clear();
+        file.seekg(0);
+
+        std::string line;
+        std::getline(file, line);
+        while(std::getline(file, line))
+        {
+            std::stringstream ss(line);
+            std::string frame, hash;
+            if(!std::getline(ss, frame, ',') || !std::getline(ss, hash))
+            {
+                continue;
+            }
+
+            Record record;
+            if(!parseField(frame, 10, record.frame) || !parseField(hash, 16, record.hash))
+            {
+                return std::nullopt;
+            }
+
+            records.push_back(record);
+        }
+
+        return records;
+    }
+}
+
+FrameHashStream::FrameHashStream()
+    : m_Stream(nullptr), m_Format(FrameHash::Format::Binary), m_Interval(1)
+{}
+
+FrameHashStream::~FrameHashStream()
+{
+    if(m_Stream)
+    {
+        m_Stream->flush();
+    }
+}
+
+auto FrameHashStream::open(const std::string& path, FrameHash::Format format, u32 interval) -> bool
+{
+    if(path == "-")
+    {
+        m_Stream = &std::cout;
+    }
+    else
+    {
+        m_File.open(path, std::ios::binary);
+        if(!m_File)
+        {
+            ERROR("Could not open '" << path << "' to write frame hashes to!");
+            return false;
+        }
+
+        m_Stream = &m_File;
+    }
+
+    m_Format   = format;
+    m_Interval = std::max<u32>(interval, 1);
+
+    if(m_Format == FrameHash::Format::Binary)
+    {
+        m_Stream->write(FrameHash::MAGIC, sizeof(FrameHash::MAGIC));
+    }
+    else
+    {
+        *m_Stream << "frame,hash\n";
+    }
+
+    return true;
+}
+
+void FrameHashStream::write(u64 frame, u64 hash)
+{
+    if(m_Format == FrameHash::Format::Binary)
+    {
+        std::array<u8, sizeof(u32) + sizeof(u64)> record;
+        for(u32 byte = 0; byte < sizeof(u32); ++byte) record[byte] = static_cast<u8>(frame >> (byte * 8));
+        for(u32 byte = 0; byte < sizeof(u64); ++byte) record[sizeof(u32) + byte] = static_cast<u8>(hash >> (byte * 8));
+
+        m_Stream->write(reinterpret_cast<const char*>(record.data()), record.size());
+    }
+    else
+    {
+        std::array<char, 40> line;
+        int length = std::snprintf(line.data(), line.size(), "%llu,%016llx\n", static_cast<unsigned long long>(frame), static_cast<unsigned long long>(hash));
+        m_Stream->write(line.data(), length);
+    }
+}
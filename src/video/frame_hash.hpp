@@ -0,0 +1,134 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+    Hashes frames, so runs can be checked against each other frame by
+    frame without keeping screenshots around.
+
+    The hash accumulates 32 byte stripes into four 64 bit lanes, each
+    multiplying the halves of the data mixed with a key that moves on
+    every stripe, so the same bytes in a different place hash
+    differently. The lanes are independent, so the SSE2 and AVX2 paths
+    run them side by side, and every path gives the same hash.
+
+    A hash stream is a list of frame numbers and their hashes, either
+    as CSV or as a compact binary file: the magic "SHFH", then a
+    little endian u32 frame number and u64 hash for each frame.
+**/
+
+namespace FrameHash
+{
+    enum class HashPath
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    enum class Format
+    {
+        Binary,
+        CSV
+    };
+
+    struct Record
+    {
+        u64 frame;
+        u64 hash;
+    };
+
+    /**
+     * @brief Checks if the CPU can run a hashing path
+     * 
+     * @param path The path to check
+     */
+    [[nodiscard]] auto isHashPathSupported(HashPath path) -> bool;
+
+    /**
+     * @brief Hashes a buffer using the fastest path available
+     * 
+     * @param data The buffer to hash
+     * 
+     * @param size The size of the buffer in bytes
+     * 
+     * @param seed A value to start the hash from
+     * @return The hash
+     */
+    [[nodiscard]] auto hash(const u8* data, u32 size, u64 seed = 0) -> u64;
+
+    /**
+     * @brief Hashes a buffer using a given path, falling back
+     * to the scalar path if the CPU doesn't support it
+     * 
+     * @param data The buffer to hash
+     * 
+     * @param size The size of the buffer in bytes
+     * 
+     * @param seed A value to start the hash from
+     * 
+     * @param path The hashing path to use
+     * @return The hash
+     */
+    [[nodiscard]] auto hash(const u8* data, u32 size, u64 seed, HashPath path) -> u64;
+
+    /**
+     * @brief Reads a hash stream in either format
+     * 
+     * @param path The path of the stream
+     * @return The frames and their hashes, or nothing if the file couldn't be read
+     */
+    [[nodiscard]] auto readStream(const std::string& path) -> std::optional<std::vector<Record>>;
+}
+
+class FrameHashStream
+{
+    public:
+        FrameHashStream();
+        ~FrameHashStream();
+
+        /**
+         * @brief Starts writing hashes to a file
+         * 
+         * @param path The path to write to, or "-" for stdout
+         * 
+         * @param format The format to write in
+         * 
+         * @param interval Only write the hash of every frame whose number is a multiple of this
+         * @return Whether the file could be opened
+         */
+        auto open(const std::string& path, FrameHash::Format format, u32 interval = 1) -> bool;
+
+        /**
+         * @brief Checks if a frame's hash should be written
+         * 
+         * @param frame The frame's number
+         */
+        [[nodiscard]] __always_inline auto wants(u64 frame) const -> bool;
+
+        /**
+         * @brief Writes a frame's hash
+         * 
+         * @param frame The frame's number
+         * 
+         * @param hash The frame's hash
+         */
+        void write(u64 frame, u64 hash);
+    private:
+        std::ofstream m_File;
+        std::ostream* m_Stream;
+        FrameHash::Format m_Format;
+        u32 m_Interval;
+};
+
+//--------------------------  Inline function implementations --------------------------//
+
+__always_inline auto FrameHashStream::wants(u64 frame) const -> bool
+{
+    return m_Stream && frame % m_Interval == 0;
+}
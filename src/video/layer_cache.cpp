@@ -0,0 +1,120 @@
+#include "core.hpp"
+
+#include "layer_cache.hpp"
+
+#include <cstring>
+
+#include "dirty_map.hpp"
+#include "tile_cache.hpp"
+
+LayerCache::LayerCache()
+    : m_Layers({}), m_RowGenerations({}), m_Generation(0), m_UnsignedTiles(false)
+{
+    // VRAM starts zeroed, so every entry points at a blank tile either way
+}
+
+template <bool CGB>
+void LayerCache::update(const u8* vram, const DirtyMap& dirtyMap, const TileCache& tileCache, bool unsignedTiles)
+{
+    bool redrawAll = unsignedTiles != m_UnsignedTiles;
+
+    if(!redrawAll && dirtyMap.getVRAMGeneration() <= m_Generation)
+    {
+        return;
+    }
+
+    // Sort what changed into tiles, and blocks of tile map entries (or their attributes)
+    std::array<bool, VRAM_BANK_COUNT * TILE_COUNT> dirtyTiles {};
+    std::array<bool, 2 * TILES_PER_MAP / DIRTY_VRAM_BLOCK_SIZE> dirtyEntries {};
+    bool anyTiles = false;
+
+    dirtyMap.forEachDirtyVRAM(m_Generation, [&](u16 address)
+    {
+        u16 bank   = (address - VRAM_START_ADDR) / VRAM_BANK_SIZE;
+        u16 offset = (address - VRAM_START_ADDR) % VRAM_BANK_SIZE;
+        if(offset < TILE_COUNT * BYTES_PER_TILE)
+        {
+            dirtyTiles[bank * TILE_COUNT + offset / BYTES_PER_TILE] = true;
+            anyTiles = true;
+        }
+        else
+        {
+            dirtyEntries[(VRAM_START_ADDR + offset - TILE_MAP_LOW) / DIRTY_VRAM_BLOCK_SIZE] = true;
+        }
+    });
+
+    for(u16 tileMapAddress : {TILE_MAP_LOW, TILE_MAP_HIGH})
+    {
+        Layer& layer = m_Layers[tileMapAddress == TILE_MAP_HIGH];
+        std::array<u64, TILES_PER_LINE>& rowGenerations = m_RowGenerations[tileMapAddress == TILE_MAP_HIGH];
+        const u8* entries    = vram + (tileMapAddress - VRAM_START_ADDR);
+        const u8* attributes = entries + VRAM_BANK_SIZE;
+        u16 firstBlock = (tileMapAddress - TILE_MAP_LOW) / DIRTY_VRAM_BLOCK_SIZE;
+
+        for(u16 block = 0; block < TILES_PER_MAP / DIRTY_VRAM_BLOCK_SIZE; ++block)
+        {
+            bool blockDirty = redrawAll || dirtyEntries[firstBlock + block];
+
+            // Only look at each entry when the block itself or some tile changed
+            if(!blockDirty && !anyTiles) continue;
+
+            for(u16 entry = block * DIRTY_VRAM_BLOCK_SIZE; entry < (block + 1) * DIRTY_VRAM_BLOCK_SIZE; ++entry)
+            {
+                u16 tile = Tile::getIndex(entries[entry], unsignedTiles);
+                u8  attribute = 0;
+                if constexpr(CGB)
+                {
+                    attribute = attributes[entry];
+                    if(bit_functions::get_bit(attribute, 3)) // Tile from bank 1
+                    {
+                        tile += TILE_COUNT;
+                    }
+                }
+
+                if(blockDirty || dirtyTiles[tile])
+                {
+                    drawTile<CGB>(layer, entry, tile, attribute, tileCache);
+                    rowGenerations[entry / TILES_PER_LINE] = dirtyMap.getGeneration();
+                }
+            }
+        }
+    }
+
+    m_Generation    = dirtyMap.getGeneration();
+    m_UnsignedTiles = unsignedTiles;
+}
+
+template <bool CGB>
+void LayerCache::drawTile(Layer& layer, u16 entry, u16 tile, u8 attributes, const TileCache& tileCache)
+{
+    u16 x = (entry % TILES_PER_LINE) * TILE_WIDTH;
+    u16 y = (entry / TILES_PER_LINE) * TILE_HEIGHT;
+
+    if constexpr(CGB)
+    {
+        bool xFlip = bit_functions::get_bit(attributes, 5);
+        bool yFlip = bit_functions::get_bit(attributes, 6);
+
+        // Tag every pixel of the row at once with the palette and priority
+        u8  tag  = ((attributes & 0x07) << Colour::PALETTE_SHIFT) | (bit_functions::get_bit(attributes, 7) << Colour::CGB_PRIORITY_BIT);
+        u64 tags = tag * 0x0101010101010101;
+
+        for(u8 row = 0; row < TILE_HEIGHT; ++row)
+        {
+            u64 pixels;
+            std::memcpy(&pixels, tileCache.getRow(tile, yFlip ? TILE_HEIGHT - 1 - row : row, xFlip), TILE_WIDTH);
+            pixels |= tags;
+            std::memcpy(&layer[x + (y + row) * BG_WIDTH], &pixels, TILE_WIDTH);
+        }
+    }
+    else
+    {
+        for(u8 row = 0; row < TILE_HEIGHT; ++row)
+        {
+            std::memcpy(&layer[x + (y + row) * BG_WIDTH], tileCache.getRow(tile, row), TILE_WIDTH);
+        }
+    }
+}
+
+template void LayerCache::update<false>(const u8*, const DirtyMap&, const TileCache&, bool);
+template void LayerCache::update<true>(const u8*, const DirtyMap&, const TileCache&, bool);
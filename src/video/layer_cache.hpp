@@ -0,0 +1,106 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+
+#include "video_defs.hpp"
+
+class DirtyMap;
+class TileCache;
+
+/**
+    Keeps both tile maps drawn out as full 256x256 layers of colour
+    indices, so a background or window line is a copy out of a layer
+    rather than a walk through the tile map.
+
+    A tile in the layer is redrawn when its tile map entry or the tile
+    it points at has been written to. Changing which tile data the
+    maps use (LCDC bit 4) redraws both layers.
+
+    In CGB mode each tile map entry also has an attribute byte in
+    VRAM bank 1, picking the tile's bank, palette, flips and priority
+    over sprites. Those layers are drawn with the palette tag and
+    priority already applied, and an attribute being written redraws
+    its tile like its entry being written does.
+**/
+
+class LayerCache
+{
+    public:
+        LayerCache();
+
+        /**
+         * @brief Redraws anything in the layers that has changed since the last update
+         * 
+         * @param vram A pointer to the start of VRAM
+         * 
+         * @param dirtyMap The dirty map tracking VRAM writes, already synced
+         * 
+         * @param tileCache The decoded tiles, already updated
+         * 
+         * @param unsignedTiles Whether the tile maps use the unsigned tile data at 0x8000
+         * 
+         * @tparam CGB Whether to draw the layers with the CGB tile attributes
+         */
+        template <bool CGB> void update(const u8* vram, const DirtyMap& dirtyMap, const TileCache& tileCache, bool unsignedTiles);
+
+        /**
+         * @brief Gets a line of a layer
+         * 
+         * @param tileMapAddress The address of the tile map the layer is drawn from
+         * 
+         * @param y The line within the layer
+         * @return A pointer to the line's 256 colour indices
+         */
+        [[nodiscard]] __always_inline auto getLine(u16 tileMapAddress, u8 y) const -> const Colour::GBColour*;
+
+        /**
+         * @brief Gets the generation a line of a layer was last redrawn in,
+         * so anything drawn from it can tell when it has changed
+         * 
+         * @param tileMapAddress The address of the tile map the layer is drawn from
+         * 
+         * @param y The line within the layer
+         */
+        [[nodiscard]] __always_inline auto getLineGeneration(u16 tileMapAddress, u8 y) const -> u64;
+    private:
+        using Layer = std::array<Colour::GBColour, BG_WIDTH * BG_HEIGHT>;
+
+        static constexpr u16 TILES_PER_MAP = TILES_PER_LINE * TILES_PER_LINE;
+
+        /**
+         * @brief Draws a single tile into a layer
+         * 
+         * @param layer The layer to draw into
+         * 
+         * @param entry The tile map entry to draw
+         * 
+         * @param tile The tile's index in the tile cache
+         * 
+         * @param attributes The entry's CGB attributes
+         * 
+         * @param tileCache The decoded tiles
+         * 
+         * @tparam CGB Whether to apply the attributes
+         */
+        template <bool CGB> static void drawTile(Layer& layer, u16 entry, u16 tile, u8 attributes, const TileCache& tileCache);
+    private:
+        std::array<Layer, 2> m_Layers;
+        std::array<std::array<u64, TILES_PER_LINE>, 2> m_RowGenerations; // One per row of tiles
+
+        u64  m_Generation;
+        bool m_UnsignedTiles;
+};
+
+//--------------------------  Inline function implementations --------------------------//
+
+__always_inline auto LayerCache::getLine(u16 tileMapAddress, u8 y) const -> const Colour::GBColour*
+{
+    return &m_Layers[tileMapAddress == TILE_MAP_HIGH][y * BG_WIDTH];
+}
+
+__always_inline auto LayerCache::getLineGeneration(u16 tileMapAddress, u8 y) const -> u64
+{
+    return m_RowGenerations[tileMapAddress == TILE_MAP_HIGH][y / TILE_HEIGHT];
+}
@@ -0,0 +1,327 @@
+#include "core.hpp"
+
+#include "pixel_fifo.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "gameboy.hpp"
+#include "video/video_defs.hpp"
+
+// Sprite pixels carry their palette and priority above the colour index
+static constexpr u8 SPRITE_PALETTE_BIT  = 2;
+static constexpr u8 SPRITE_PRIORITY_BIT = 3;
+
+PixelFIFO::PixelFIFO(Gameboy& gb, const VideoRegisters& registers)
+    : m_Gameboy(gb), m_Registers(registers), m_VRAM(nullptr), m_Line({}), m_LineNumber(0), m_WindowLine(0),
+      m_Dots(0), m_Stall(0), m_X(0), m_Discard(0),
+      m_Background({}), m_BackgroundHead(0), m_BackgroundSize(0), m_Sprites({}), m_SpriteHead(0),
+      m_FetchStep(FetchStep::Tile), m_FetchDots(0), m_FetchX(0), m_TileID(0), m_TileRow({}),
+      m_WindowReached(false), m_InWindow(false),
+      m_LineSprites({}), m_SpriteCount(0), m_SpriteHeight(SPRITE_HEIGHT), m_FetchingSprite(-1) {}
+
+void PixelFIFO::startLine(u8 line, u8 windowLine)
+{
+    m_VRAM       = m_Gameboy.getVRAM();
+    m_LineNumber = line;
+    m_WindowLine = windowLine;
+
+    m_Dots    = 0;
+    m_Stall   = STARTUP_DOTS;
+    m_X       = 0;
+    m_Discard = m_Registers.scrollX % TILE_WIDTH; // Fine scroll is thrown away from the first tile
+
+    m_BackgroundHead = 0;
+    m_BackgroundSize = 0;
+    m_Sprites.fill(0);
+    m_SpriteHead = 0;
+
+    m_FetchStep = FetchStep::Tile;
+    m_FetchDots = 0;
+    m_FetchX    = 0;
+
+    // The window can only start once WY has matched a line this frame
+    if(line == 0)
+    {
+        m_WindowReached = false;
+    }
+    if(m_Registers.windowY == line)
+    {
+        m_WindowReached = true;
+    }
+    m_InWindow = false;
+
+    // The OAM scan keeps the first 10 sprites on the line, in OAM order
+    u8 lcdc = m_Registers.lcdc;
+    m_SpriteHeight = bit_functions::get_bit(lcdc, 2) ? 2 * SPRITE_HEIGHT : SPRITE_HEIGHT;
+    m_SpriteCount  = 0;
+    m_FetchingSprite = -1;
+
+    const u8* oam = m_Gameboy.getOAM();
+    for(u8 i = 0; i < SPRITE_COUNT && m_SpriteCount < SPRITES_PER_LINE; ++i)
+    {
+        const u8* sprite = oam + i * BYTES_PER_SPRITE;
+
+        int top = sprite[0] - SPRITE_Y_OFFSET;
+        if(line >= top && line < top + m_SpriteHeight)
+        {
+            m_LineSprites[m_SpriteCount++] = { sprite[0], sprite[1], sprite[2], sprite[3], false };
+        }
+    }
+}
+
+auto PixelFIFO::tick(u16 dots) -> u16
+{
+    u16 used = 0;
+    for(; used < dots && !isDone(); ++used)
+    {
+        step();
+    }
+    return used;
+}
+
+auto PixelFIFO::isDone() const -> bool
+{
+    return m_X == SCREEN_WIDTH;
+}
+
+auto PixelFIFO::getLength() const -> u16
+{
+    return m_Dots;
+}
+
+auto PixelFIFO::usedWindow() const -> bool
+{
+    return m_InWindow;
+}
+
+auto PixelFIFO::getLine() const -> const std::array<u8, SCREEN_WIDTH>&
+{
+    return m_Line;
+}
+
+void PixelFIFO::step()
+{
+    m_Dots++;
+
+    // The first fetch of the line, and each sprite fetch, hold everything else up
+    if(m_Stall > 0)
+    {
+        if(--m_Stall == 0 && m_FetchingSprite >= 0)
+        {
+            fetchSprite(m_LineSprites[m_FetchingSprite]);
+            m_FetchingSprite = -1;
+        }
+        return;
+    }
+
+    u8 lcdc = m_Registers.lcdc;
+
+    // window x scroll has an offset of 7, so the window starts once the next pixel is WX - 7
+    if(!m_InWindow && m_WindowReached && bit_functions::get_bit(lcdc, 5) && m_X + WINDOW_X_OFFSET >= m_Registers.windowX)
+    {
+        startWindow();
+    }
+
+    // A sprite starting here has to wait for the fetcher to finish the tile it's on,
+    // and no pixels go out until it has been fetched
+    if(bit_functions::get_bit(lcdc, 1) && m_Discard == 0)
+    {
+        int sprite = findSprite();
+        if(sprite >= 0)
+        {
+            if(m_FetchStep == FetchStep::Push && m_BackgroundSize > 0)
+            {
+                m_FetchingSprite = sprite;
+                m_Stall = SPRITE_FETCH_DOTS - 1;
+            }
+            else
+            {
+                stepFetcher();
+            }
+            return;
+        }
+    }
+
+    stepFetcher();
+
+    if(m_BackgroundSize > 0)
+    {
+        pushPixel();
+    }
+}
+
+void PixelFIFO::stepFetcher()
+{
+    if(m_FetchStep != FetchStep::Push && ++m_FetchDots < DOTS_PER_FETCH_STEP)
+    {
+        return;
+    }
+    m_FetchDots = 0;
+
+    u8 lcdc = m_Registers.lcdc;
+
+    // The row of the tile map being drawn, which the window counts separately
+    u8 y = m_InWindow ? m_WindowLine : static_cast<u8>(m_LineNumber + m_Registers.scrollY);
+
+    switch(m_FetchStep)
+    {
+        case FetchStep::Tile:
+        {
+            u16 tileMapAddress;
+            u8  x;
+            if(m_InWindow)
+            {
+                tileMapAddress = bit_functions::get_bit(lcdc, 6) ? TILE_MAP_HIGH : TILE_MAP_LOW;
+                x = m_FetchX;
+            }
+            else
+            {
+                tileMapAddress = bit_functions::get_bit(lcdc, 3) ? TILE_MAP_HIGH : TILE_MAP_LOW;
+                x = (m_Registers.scrollX / TILE_WIDTH + m_FetchX) % TILES_PER_LINE;
+            }
+
+            m_TileID = m_VRAM[tileMapAddress - VRAM_START_ADDR + (y / TILE_HEIGHT) * TILES_PER_LINE + x];
+            m_FetchStep = FetchStep::DataLow;
+            break;
+        }
+        case FetchStep::DataLow:
+        case FetchStep::DataHigh:
+        {
+            u8  plane = m_FetchStep == FetchStep::DataHigh;
+            u16 tile  = Tile::getIndex(m_TileID, bit_functions::get_bit(lcdc, 4));
+
+            m_TileRow[plane] = m_VRAM[tile * BYTES_PER_TILE + (y % TILE_HEIGHT) * 2 + plane];
+            m_FetchStep = plane ? FetchStep::Push : FetchStep::DataHigh;
+            break;
+        }
+        case FetchStep::Push:
+            // The fetcher waits until the background FIFO has room for a whole tile
+            if(m_BackgroundSize == 0)
+            {
+                u64 pixels = Tile::decodeRow(m_TileRow.data());
+                std::memcpy(m_Background.data(), &pixels, TILE_WIDTH);
+
+                m_BackgroundHead = 0;
+                m_BackgroundSize = TILE_WIDTH;
+
+                m_FetchX++;
+                m_FetchStep = FetchStep::Tile;
+            }
+            break;
+    }
+}
+
+auto PixelFIFO::findSprite() const -> int
+{
+    for(u8 i = 0; i < m_SpriteCount; ++i)
+    {
+        const Sprite& sprite = m_LineSprites[i];
+
+        // Sprites hanging off the left of the screen are fetched as the line starts
+        if(!sprite.fetched && std::max(sprite.x - SPRITE_X_OFFSET, 0) == m_X)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void PixelFIFO::fetchSprite(Sprite& sprite)
+{
+    sprite.fetched = true;
+
+    bool xFlip = bit_functions::get_bit(sprite.attributes, 5);
+    bool yFlip = bit_functions::get_bit(sprite.attributes, 6);
+
+    // Tall sprites ignore the lowest bit of the tile index
+    u8 tileID = sprite.tile;
+    if(m_SpriteHeight != SPRITE_HEIGHT)
+    {
+        bit_functions::clear_bit(tileID, 0);
+    }
+
+    u8 row = m_LineNumber - (sprite.y - SPRITE_Y_OFFSET);
+    if(yFlip)
+    {
+        row = m_SpriteHeight - 1 - row;
+    }
+
+    // Tall sprites carry on into the next tile
+    const u8* data = m_VRAM + (tileID + row / TILE_HEIGHT) * BYTES_PER_TILE + (row % TILE_HEIGHT) * 2;
+
+    std::array<u8, TILE_WIDTH> pixels;
+    u64 decoded = Tile::decodeRow(data, xFlip);
+    std::memcpy(pixels.data(), &decoded, TILE_WIDTH);
+
+    u8 flags = (bit_functions::get_bit(sprite.attributes, 4) << SPRITE_PALETTE_BIT)
+             | (bit_functions::get_bit(sprite.attributes, 7) << SPRITE_PRIORITY_BIT);
+
+    // Pixels off the left of the screen never make it into the FIFO
+    u8 hidden = sprite.x < SPRITE_X_OFFSET ? SPRITE_X_OFFSET - sprite.x : 0;
+
+    for(u8 i = hidden; i < TILE_WIDTH; ++i)
+    {
+        u8& slot = m_Sprites[(m_SpriteHead + i - hidden) % TILE_WIDTH];
+
+        // Sprites already in the FIFO came first, so they keep their pixels.
+        // Colour index 0 is transparent, whatever shade the palette gives it
+        if((slot & Colour::COLOUR_MASK) == 0 && pixels[i] != Colour::GBColour::WHITE)
+        {
+            slot = pixels[i] | flags;
+        }
+    }
+}
+
+void PixelFIFO::startWindow()
+{
+    m_InWindow = true;
+
+    m_BackgroundHead = 0;
+    m_BackgroundSize = 0;
+
+    m_FetchStep = FetchStep::Tile;
+    m_FetchDots = 0;
+    m_FetchX    = 0;
+
+    // A window starting partly off the left of the screen loses those pixels instead
+    u8 windowX = m_Registers.windowX;
+    m_Discard = windowX < WINDOW_X_OFFSET ? WINDOW_X_OFFSET - windowX : 0;
+}
+
+void PixelFIFO::pushPixel()
+{
+    u8 background = m_Background[m_BackgroundHead++];
+    m_BackgroundSize--;
+
+    if(m_Discard > 0)
+    {
+        m_Discard--;
+        return;
+    }
+
+    u8 sprite = m_Sprites[m_SpriteHead];
+    m_Sprites[m_SpriteHead] = 0;
+    m_SpriteHead = (m_SpriteHead + 1) % TILE_WIDTH;
+
+    // With the background off it's drawn as colour 0, though it's still fetched
+    if(!bit_functions::get_bit(m_Registers.lcdc, 0))
+    {
+        background = Colour::GBColour::WHITE;
+    }
+
+    // Sprites win unless they're behind a background that isn't colour 0
+    u8 colour  = sprite & Colour::COLOUR_MASK;
+    u8 palette = m_Registers.bgp;
+    if(colour != Colour::GBColour::WHITE && !(bit_functions::get_bit(sprite, SPRITE_PRIORITY_BIT) && background != Colour::GBColour::WHITE))
+    {
+        palette = bit_functions::get_bit(sprite, SPRITE_PALETTE_BIT) ? m_Registers.obp1 : m_Registers.obp0;
+    }
+    else
+    {
+        colour = background;
+    }
+
+    // The palette is applied as the pixel goes out, so mid line palette writes show up where they happen
+    m_Line[m_X++] = (palette >> (colour * 2)) & Colour::COLOUR_MASK;
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+
+#include "video_defs.hpp"
+
+class Gameboy;
+
+/**
+    Draws a line the way the hardware does during mode 3, one dot at a
+    time: a fetcher reads the tile map and tile data into a background
+    FIFO, and a pixel is shifted out of it every dot, mixed with
+    whatever sprite pixels are waiting in the sprite FIFO.
+
+    Mode 3 then lasts as long as it takes to push out 160 pixels, which
+    grows with the fine scroll discarded at the start of the line, the
+    fetcher restarting for the window, and the fetcher stalling for
+    each sprite. Registers are read as the pixels that use them are
+    drawn, so writes in the middle of a line land where they would on
+    the hardware.
+**/
+
+class PixelFIFO
+{
+    public:
+        PixelFIFO(Gameboy& gb, const VideoRegisters& registers);
+
+        /**
+         * @brief Starts drawing a line, once the OAM scan has finished
+         * 
+         * @param line The line to draw
+         * 
+         * @param windowLine The window's own line counter
+         */
+        void startLine(u8 line, u8 windowLine);
+
+        /**
+         * @brief Runs the FIFO for up to a number of dots, stopping early if the line is finished
+         * 
+         * @param dots The number of dots that have passed
+         * @return The number of dots used
+         */
+        auto tick(u16 dots) -> u16;
+
+        /**
+         * @brief Checks if all 160 pixels of the line have been pushed out
+         * 
+         */
+        [[nodiscard]] auto isDone() const -> bool;
+
+        /**
+         * @brief Gets the number of dots mode 3 has lasted so far
+         * 
+         */
+        [[nodiscard]] auto getLength() const -> u16;
+
+        /**
+         * @brief Checks if the window was drawn on the line,
+         * so the window line counter should move on
+         * 
+         */
+        [[nodiscard]] auto usedWindow() const -> bool;
+
+        /**
+         * @brief Gets the line drawn, as shades from 0 (lightest) to 3 (darkest)
+         * 
+         */
+        [[nodiscard]] auto getLine() const -> const std::array<u8, SCREEN_WIDTH>&;
+    private:
+        struct Sprite
+        {
+            u8 y;
+            u8 x;
+            u8 tile;
+            u8 attributes;
+            bool fetched;
+        };
+
+        enum class FetchStep
+        {
+            Tile,       // Read the tile map entry
+            DataLow,    // Read the low bitplane of the tile's row
+            DataHigh,   // Read the high bitplane
+            Push        // Wait for the background FIFO to empty, then refill it
+        };
+
+        // Each fetch step takes two dots, as does the first fetch of a line, which is thrown away
+        static constexpr u8 DOTS_PER_FETCH_STEP = 2;
+        static constexpr u8 STARTUP_DOTS        = 6;
+        static constexpr u8 SPRITE_FETCH_DOTS   = 6;
+
+        /**
+         * @brief Runs the FIFO for a single dot
+         * 
+         */
+        void step();
+
+        /**
+         * @brief Moves the background fetcher on by a dot
+         * 
+         */
+        void stepFetcher();
+
+        /**
+         * @brief Finds a sprite waiting to be fetched at the current x position
+         * 
+         * @return The sprite's index in the line's sprites, or -1 if there isn't one
+         */
+        [[nodiscard]] auto findSprite() const -> int;
+
+        /**
+         * @brief Fetches a sprite's row, and mixes it into the sprite FIFO
+         * 
+         * @param sprite The sprite to fetch
+         */
+        void fetchSprite(Sprite& sprite);
+
+        /**
+         * @brief Restarts the fetcher on the window, clearing the background FIFO
+         * 
+         */
+        void startWindow();
+
+        /**
+         * @brief Shifts a pixel out of the FIFOs, and draws it unless it's being discarded
+         * 
+         */
+        void pushPixel();
+    private:
+        Gameboy& m_Gameboy;
+        const VideoRegisters& m_Registers;
+        const u8* m_VRAM;
+
+        std::array<u8, SCREEN_WIDTH> m_Line;
+        u8 m_LineNumber;
+        u8 m_WindowLine;
+
+        u16 m_Dots;
+        u8  m_Stall;
+        u8  m_X;
+        u8  m_Discard;
+
+        // Background pixels are colour indices, sprite pixels also carry their palette and priority
+        std::array<u8, TILE_WIDTH> m_Background;
+        u8 m_BackgroundHead;
+        u8 m_BackgroundSize;
+        std::array<u8, TILE_WIDTH> m_Sprites;
+        u8 m_SpriteHead;
+
+        FetchStep m_FetchStep;
+        u8  m_FetchDots;
+        u8  m_FetchX;
+        u8  m_TileID;
+        std::array<u8, 2> m_TileRow;
+
+        bool m_WindowReached;
+        bool m_InWindow;
+
+        std::array<Sprite, SPRITES_PER_LINE> m_LineSprites;
+        u8 m_SpriteCount;
+        u8 m_SpriteHeight;
+        int m_FetchingSprite;
+};
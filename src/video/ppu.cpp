@@ -6,67 +6,288 @@
 #include "gameboy.hpp"
 #include "video/video_defs.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 PPU::PPU(Gameboy& gb)
-    : m_Gameboy(gb), m_Mode(VideoMode::OAM_Scan), m_Cycles(0), m_Line(0)
+    : m_Gameboy(gb), m_Registers({}), m_ColoursChanged(true), m_CGB(false), m_Renderer(m_Frames), m_PixelFIFO(gb, m_Registers), m_RenderMode(RenderMode::Scanline), m_BlockCount(0), m_SnapshotGeneration(0),
+      m_Submitted(0), m_Completed(0), m_Stopping(false),
+      m_Mode(VideoMode::HBlank), m_Enabled(false), m_Cycles(0), m_HBlankCycles(CYCLES_PER_HBLANK), m_Line(0), m_WindowLine(0),
+      m_RenderSkip(RenderSkip::Never), m_RenderInterval(1), m_FramesSinceRender(0), m_FrameRequested(false), m_Rendering(true),
+      m_HashStream(nullptr), m_FrameNumber(0), m_Recorder(nullptr)
 {
     DEBUG("Initializing GPU.");
+
+    // Palette ram starts out white
+    m_PaletteRAM.fill(0xFF);
+    m_Colours.fill(Colour::toPixel(Colour::fromRGB555(0x7FFF)));
+
+    // With a core to spare, lines are drawn alongside the CPU rather than in between its instructions
+    if(std::thread::hardware_concurrency() > 1)
+    {
+        m_RenderThread = std::thread(&PPU::renderLoop, this);
+    }
+}
+
+PPU::~PPU()
+{
+    if(m_RenderThread.joinable())
+    {
+        m_Stopping.store(true, std::memory_order_relaxed);
+        m_Submitted.fetch_add(1, std::memory_order_release);
+        m_Submitted.notify_one();
+        m_RenderThread.join();
+    }
+}
+
+auto PPU::getFrameExchange() -> FrameExchange&
+{
+    return m_Frames;
+}
+
+auto PPU::readRegister(u16 address) const -> u8
+{
+    switch(address)
+    {
+        case LCD_CONTROL_REGISTER:
+            return m_Registers.lcdc;
+        case LCD_STAT_REGISTER:
+            return STAT_UNUSED_BITS | m_Registers.stat
+                 | ((m_Line == m_Registers.lyc) << STAT_LCY_LY_BIT)
+                 | static_cast<u8>(m_Mode);
+        case SCY_REGISTER:
+            return m_Registers.scrollY;
+        case SCX_REGISTER:
+            return m_Registers.scrollX;
+        case LY_REGISTER:
+            return m_Line;
+        case LYC_REGISTER:
+            return m_Registers.lyc;
+        case BG_PALLETTE_REGISTER:
+            return m_Registers.bgp;
+        case OBJ_0_PALLETTE_REGISTER:
+            return m_Registers.obp0;
+        case OBJ_1_PALLETTE_REGISTER:
+            return m_Registers.obp1;
+        case WY_REGISTER:
+            return m_Registers.windowY;
+        case WX_REGISTER:
+            return m_Registers.windowX;
+        case BG_PALETTE_INDEX_REGISTER:
+            return m_Registers.bgPaletteIndex | 0x40; // Bit 6 is unused
+        case BG_PALETTE_DATA_REGISTER:
+            return m_PaletteRAM[m_Registers.bgPaletteIndex & PALETTE_INDEX_MASK];
+        case OBJ_PALETTE_INDEX_REGISTER:
+            return m_Registers.objPaletteIndex | 0x40;
+        case OBJ_PALETTE_DATA_REGISTER:
+            return m_PaletteRAM[CGB_PALETTE_RAM_SIZE + (m_Registers.objPaletteIndex & PALETTE_INDEX_MASK)];
+        default:
+            ASSERT(false, "Invalid PPU register!");
+            return UINT8_MAX;
+    }
+}
+
+void PPU::writeRegister(u16 address, u8 val)
+{
+    switch(address)
+    {
+        case LCD_CONTROL_REGISTER:
+            m_Registers.lcdc = val;
+            setEnabled(bit_functions::get_bit(val, LCD_ENABLE_BIT));
+            break;
+        case LCD_STAT_REGISTER:
+            m_Registers.stat = val & STAT_WRITABLE_MASK;
+            break;
+        case SCY_REGISTER:
+            m_Registers.scrollY = val;
+            break;
+        case SCX_REGISTER:
+            m_Registers.scrollX = val;
+            break;
+        case LY_REGISTER: // Read only
+            break;
+        case LYC_REGISTER:
+            m_Registers.lyc = val;
+            break;
+        case BG_PALLETTE_REGISTER:
+            m_Registers.bgp = val;
+            break;
+        case OBJ_0_PALLETTE_REGISTER:
+            m_Registers.obp0 = val;
+            break;
+        case OBJ_1_PALLETTE_REGISTER:
+            m_Registers.obp1 = val;
+            break;
+        case WY_REGISTER:
+            m_Registers.windowY = val;
+            break;
+        case WX_REGISTER:
+            m_Registers.windowX = val;
+            break;
+        case BG_PALETTE_INDEX_REGISTER:
+            m_Registers.bgPaletteIndex = val & ~0x40;
+            break;
+        case BG_PALETTE_DATA_REGISTER:
+            writePaletteData(m_Registers.bgPaletteIndex, 0, val);
+            break;
+        case OBJ_PALETTE_INDEX_REGISTER:
+            m_Registers.objPaletteIndex = val & ~0x40;
+            break;
+        case OBJ_PALETTE_DATA_REGISTER:
+            writePaletteData(m_Registers.objPaletteIndex, CGB_PALETTE_RAM_SIZE, val);
+            break;
+        default:
+            ASSERT(false, "Invalid PPU register!");
+    }
 }
 
-void PPU::setDrawCallback(std::function<void(std::array<u8, FRAME_BUFFER_SIZE> buffer)> callback)
+void PPU::writePaletteData(u8& index, u8 offset, u8 val)
 {
-    m_DrawCallback = callback;
+    u8 address = offset + (index & PALETTE_INDEX_MASK);
+    m_PaletteRAM[address] = val;
+
+    // Colours are two bytes, low byte first, and get converted to pixels as they're written
+    u8 colour = address / 2;
+    u16 rgb555 = m_PaletteRAM[colour * 2] | (m_PaletteRAM[colour * 2 + 1] << 8);
+    m_Colours[colour] = Colour::toPixel(Colour::fromRGB555(rgb555));
+    m_ColoursChanged = true;
+
+    if(bit_functions::get_bit(index, PALETTE_AUTO_INC_BIT))
+    {
+        index = (index & ~PALETTE_INDEX_MASK) | ((index + 1) & PALETTE_INDEX_MASK);
+    }
+}
+
+void PPU::setEnabled(bool enabled)
+{
+    if(enabled == m_Enabled)
+    {
+        return;
+    }
+
+    m_Enabled = enabled;
+
+    m_Cycles     = 0;
+    m_Line       = 0;
+    m_WindowLine = 0;
+
+    if(enabled)
+    {
+        // Start a fresh frame from the top
+        m_Mode = VideoMode::OAM_Scan;
+        m_Rendering = shouldRenderFrame();
+    }
+    else
+    {
+        // LY is held at 0 and STAT reads as HBlank until the LCD comes back on
+        m_Mode = VideoMode::HBlank;
+
+        // The screen goes blank, throwing away whatever was drawn of the frame
+        if(m_Rendering)
+        {
+            waitForRenderer();
+            m_BlockCount = 0;
+
+            m_Renderer.clear();
+            m_Frames.publish();
+        }
+    }
+}
+
+void PPU::setRenderMode(RenderMode mode)
+{
+    // The pixel FIFO only knows how to draw DMG lines
+    if(m_CGB && mode == RenderMode::PixelFIFO)
+    {
+        return;
+    }
+
+    waitForRenderer();
+    m_RenderMode   = mode;
+    m_HBlankCycles = CYCLES_PER_HBLANK;
+}
+
+void PPU::setRenderSkip(RenderSkip skip, u32 interval)
+{
+    m_RenderSkip        = skip;
+    m_RenderInterval    = std::max<u32>(interval, 1);
+    m_FramesSinceRender = 0;
+}
+
+void PPU::requestFrame()
+{
+    m_FrameRequested.store(true, std::memory_order_relaxed);
+}
+
+void PPU::setFrameHashStream(FrameHashStream* stream)
+{
+    m_HashStream = stream;
+}
+
+void PPU::setRecorder(Recorder* recorder)
+{
+    m_Recorder = recorder;
 }
 
 void PPU::tick(u8 cycles)
 {
+    if(!m_Enabled) // Nothing happens while the LCD is off
+    {
+        return;
+    }
+
     m_Cycles += cycles;
 
     switch(m_Mode)
     {
         case VideoMode::HBlank: // Mode 0
-            if(m_Cycles >= CYCLES_PER_HBLANK)
+            if(m_Cycles >= m_HBlankCycles)
             {
-                m_Cycles -= CYCLES_PER_HBLANK;
+                m_Cycles -= m_HBlankCycles;
 
-                drawBackgroundLine(m_Line);
-                drawWindowLine(m_Line);
-                drawSprites(m_Line);
-                
                 m_Line++;
 
                 if(m_Line == SCREEN_HEIGHT)
                 {
-                    m_Mode = VideoMode::VBlank;
-                    m_Gameboy.raiseInterrupt(Flags::Interrupt::VBlank);
+                    // The frame can only be published once every line of it has been drawn
+                    if(m_Rendering)
+                    {
+                        waitForRenderer();
+                        m_BlockCount = 0;
 
-                    u8 stat = m_Gameboy.read(LCD_STAT_REGISTER);
+                        // The back buffer is only whole until it's published
+                        if(m_Recorder)
+                        {
+                            m_Recorder->submit(m_Frames.getBackBuffer(), m_Renderer.getColourBuffer(), m_Renderer.getLinePalettes(), m_CGB);
+                        }
 
-                    bit_functions::set_bit_to(stat, 0, 1);
-                    bit_functions::set_bit_to(stat, 1, 0);
+                        m_Frames.publish(m_Renderer.finishFrame());
+
+                        if(m_HashStream && m_HashStream->wants(m_FrameNumber))
+                        {
+                            m_HashStream->write(m_FrameNumber, m_Renderer.getFrameHash());
+                        }
+                    }
+                    m_FrameNumber++;
+
+                    m_Mode = VideoMode::VBlank;
+                    m_Gameboy.raiseInterrupt(Flags::Interrupt::VBlank);
+                    m_Gameboy.applyCheats();
 
                     // STAT interrupt checks OAM bit as well
-                    if(bit_functions::get_bit(stat, STAT_VBLANK_BIT) || bit_functions::get_bit(stat, STAT_OAM_BIT))
+                    if(bit_functions::get_bit(m_Registers.stat, STAT_VBLANK_BIT) || bit_functions::get_bit(m_Registers.stat, STAT_OAM_BIT))
                     {
                         m_Gameboy.raiseInterrupt(Flags::Interrupt::LCD_STAT);
                     }
-
-                    m_Gameboy.write(LCD_STAT_REGISTER, stat);
                 }
                 else
                 {
                     m_Mode = VideoMode::OAM_Scan;
 
-                    u8 stat = m_Gameboy.read(LCD_STAT_REGISTER);
-
-                    bit_functions::set_bit_to(stat, 0, 0);
-                    bit_functions::set_bit_to(stat, 1, 1);
-
-                    if(bit_functions::get_bit(stat, STAT_OAM_BIT))
+                    if(bit_functions::get_bit(m_Registers.stat, STAT_OAM_BIT))
                     {
                         m_Gameboy.raiseInterrupt(Flags::Interrupt::LCD_STAT);
                     }
-
-                    m_Gameboy.write(LCD_STAT_REGISTER, stat);
                 }
             }
             break;
@@ -80,20 +301,14 @@ void PPU::tick(u8 cycles)
                 {
                     m_Mode = VideoMode::OAM_Scan;
 
-                    std::invoke(m_DrawCallback, m_FrameBuffer);
                     m_Line = 0;
-                    
-                    u8 stat = m_Gameboy.read(LCD_STAT_REGISTER);
-                    
-                    bit_functions::set_bit_to(stat, 0, 0);
-                    bit_functions::set_bit_to(stat, 1, 1);
+                    m_WindowLine = 0;
+                    m_Rendering = shouldRenderFrame();
 
-                    if(bit_functions::get_bit(stat, STAT_OAM_BIT))
+                    if(bit_functions::get_bit(m_Registers.stat, STAT_OAM_BIT))
                     {
                         m_Gameboy.raiseInterrupt(Flags::Interrupt::LCD_STAT);
                     }
-
-                    m_Gameboy.write(LCD_STAT_REGISTER, stat);
                 };
             }
             break;
@@ -103,55 +318,74 @@ void PPU::tick(u8 cycles)
                 m_Cycles -= CYCLES_PER_OAM_SCAN;
 
                 m_Mode = VideoMode::Transfer;
-                
-                u8 stat = m_Gameboy.read(LCD_STAT_REGISTER);
-                
-                bit_functions::set_bit_to(stat, 0, 1);
-                bit_functions::set_bit_to(stat, 1, 1);
 
-                m_Gameboy.write(LCD_STAT_REGISTER, stat);
+                if(m_RenderMode == RenderMode::PixelFIFO)
+                {
+                    // The FIFO runs whether the frame is rendered or not, as it decides how long mode 3 is
+                    m_PixelFIFO.startLine(m_Line, m_WindowLine);
+                }
+                else if(m_Rendering)
+                {
+                    submitLine(m_Line);
+                }
             }
             break;
         case VideoMode::Transfer: // Mode 3
-            if(m_Cycles >= CYCLES_PER_TRANSFER)
+        {
+            if(m_RenderMode == RenderMode::PixelFIFO)
             {
-                m_Cycles -= CYCLES_PER_TRANSFER;
+                // Mode 3 lasts until the FIFO has pushed out the whole line, and HBlank makes up the rest
+                m_Cycles -= m_PixelFIFO.tick(m_Cycles);
+                if(!m_PixelFIFO.isDone())
+                {
+                    break;
+                }
 
-                m_Mode = VideoMode::HBlank;
-                
-                u8 stat = m_Gameboy.read(LCD_STAT_REGISTER);
-                
-                bit_functions::set_bit_to(stat, 0, 0);
-                bit_functions::set_bit_to(stat, 1, 0);
+                m_HBlankCycles = CYCLES_PER_LINE - CYCLES_PER_OAM_SCAN - m_PixelFIFO.getLength();
 
-                if(bit_functions::get_bit(stat, STAT_HBLANK_BIT))
+                // The window keeps its own line counter, which only moves on lines it was drawn on
+                if(m_PixelFIFO.usedWindow())
                 {
-                    m_Gameboy.raiseInterrupt(Flags::Interrupt::LCD_STAT);
+                    m_WindowLine++;
                 }
 
-                // LYC enabled
-                if(bit_functions::get_bit(stat, STAT_LYC_BIT))
+                if(m_Rendering)
                 {
-                    u8 lyc = m_Gameboy.read(LYC_REGISTER);
-                    if(m_Line == lyc)
-                    {
-                        bit_functions::set_bit(stat, STAT_LCY_LY_BIT);
-                        m_Gameboy.raiseInterrupt(Flags::Interrupt::LCD_STAT);
-                    }
-                    else
-                    {
-                        bit_functions::clear_bit(stat, STAT_LCY_LY_BIT);
-                    }
+                    m_Renderer.presentLine(m_Line, m_PixelFIFO.getLine());
                 }
+            }
+            else if(m_Cycles >= CYCLES_PER_TRANSFER)
+            {
+                m_Cycles -= CYCLES_PER_TRANSFER;
+            }
+            else
+            {
+                break;
+            }
+
+            m_Mode = VideoMode::HBlank;
+
+            // A HBlank DMA copies a block at the start of each HBlank
+            if(m_CGB) [[unlikely]]
+            {
+                m_Gameboy.stepHDMA();
+            }
+
+            if(bit_functions::get_bit(m_Registers.stat, STAT_HBLANK_BIT))
+            {
+                m_Gameboy.raiseInterrupt(Flags::Interrupt::LCD_STAT);
+            }
 
-                m_Gameboy.write(LCD_STAT_REGISTER, stat);
+            // LYC enabled
+            if(bit_functions::get_bit(m_Registers.stat, STAT_LYC_BIT) && m_Line == m_Registers.lyc)
+            {
+                m_Gameboy.raiseInterrupt(Flags::Interrupt::LCD_STAT);
             }
             break;
+        }
         default:
             ASSERT(false, "Invalid PPU Mode!");
     }
-
-    m_Gameboy.write(LY_REGISTER, m_Line);
 }
 
 auto PPU::getMode() const -> VideoMode
@@ -159,240 +393,152 @@ auto PPU::getMode() const -> VideoMode
     return m_Mode;
 }
 
-void PPU::drawBackgroundLine(u8 line)
+auto PPU::shouldRenderFrame() -> bool
 {
-    u8 lcdc = m_Gameboy.read(LCD_CONTROL_REGISTER);
-
-    u8 scrollX = m_Gameboy.read(SCX_REGISTER);
-    u8 scrollY = m_Gameboy.read(SCY_REGISTER);
-
-    u16 tileMapAddress  = bit_functions::get_bit(lcdc, 3) ? TILE_MAP_HIGH  : TILE_MAP_LOW;
-    u16 tileDataAddress = bit_functions::get_bit(lcdc, 4) ? TILE_DATA_HIGH : TILE_DATA_LOW;
-
-    for(u8 col = 0; col < SCREEN_WIDTH; ++col)
+    switch(m_RenderSkip)
     {
-        // get the x and y position in the background
-        u8 xPos = col  + scrollX;
-        u8 yPos = line + scrollY;
-
-        // get the x and y position of the tile within the background
-        u8 tileXPos = xPos / TILE_WIDTH;
-        u8 tileYPos = yPos / TILE_HEIGHT;
-
-        // get the x and y position of the pixel within the tile
-        u8 pixelXPos = xPos % TILE_WIDTH;
-        u8 pixelYPos = yPos % TILE_HEIGHT;
-
-        // get the tile index number and the tile within the tile map
-        u16 tileIndex = tileXPos + tileYPos * TILES_PER_LINE;
-        u8  tileID    = m_Gameboy.read(tileMapAddress + tileIndex);
-
-        // get the memory offset of the tile in the tile data
-        // if we're using tile data one we need treat the offset as signed from 128
-        u16 tileDataOffset = (tileDataAddress == TILE_DATA_HIGH)
-                           ? (tileID                                   ) * BYTES_PER_TILE
-                           : (static_cast<i8>(tileID) + TILE_ONE_OFFSET) * BYTES_PER_TILE;
-
-        // add 2 bytes/line based on the y offset into the tile
-        u16 tileAddress = tileDataAddress + tileDataOffset + 2 * pixelYPos;
-
-        u8 low  = m_Gameboy.read(tileAddress    );
-        u8 high = m_Gameboy.read(tileAddress + 1);
-
-        Colour::GBColour c = getGBColour(pixelXPos, tileAddress);
-        drawPixel(col, line, c);
+        case RenderSkip::Interval:
+            if(++m_FramesSinceRender < m_RenderInterval)
+            {
+                return false;
+            }
+            m_FramesSinceRender = 0;
+            return true;
+        case RenderSkip::OnDemand:
+            return m_FrameRequested.exchange(false, std::memory_order_relaxed);
+        default:
+            return true;
     }
 }
 
-void PPU::drawWindowLine(u8 line)
+void PPU::submitLine(u8 line)
 {
-    u8 lcdc = m_Gameboy.read(LCD_CONTROL_REGISTER);
+    DirtyMap& dirtyMap = m_Gameboy.getDirtyMap();
+    dirtyMap.sync();
 
-    if(!bit_functions::get_bit(lcdc, 5)) // Window not rendering
+    // Make sure there's room for every block of VRAM to have changed,
+    // waiting for the renderer to finish with the ones before if not
+    if(m_BlockCount + VRAM_BLOCKS > m_Blocks.size())
     {
-        return;
+        waitForRenderer();
+        m_BlockCount = 0;
     }
 
-    u8 windowX = m_Gameboy.read(WX_REGISTER) - 7; // window x scroll has an offset of 7
+    Renderer::LineState& state = m_Lines[m_Submitted.load(std::memory_order_relaxed) % SCREEN_HEIGHT];
 
-    if(windowX >= SCREEN_WIDTH) // Don't render the window if it's to the right of the screen
+    state.line        = line;
+    state.lcdc        = m_Registers.lcdc;
+    state.scrollX     = m_Registers.scrollX;
+    state.scrollY     = m_Registers.scrollY;
+    state.windowX     = m_Registers.windowX;
+    state.windowY     = m_Registers.windowY;
+    state.palettes    = { m_Registers.bgp, m_Registers.obp0, m_Registers.obp1 };
+    state.windowLine  = m_WindowLine;
+
+    // The window keeps its own line counter, which only moves on lines it was drawn on
+    if(Renderer::isWindowVisible(state))
     {
-        return;
+        m_WindowLine++;
     }
 
-    u8 windowY = m_Gameboy.read(WY_REGISTER);
+    // Copy out whatever VRAM and OAM were written since the last line, as the renderer can't read them
+    const u8* vram = m_Gameboy.getVRAM();
 
-    if(windowY >= SCREEN_HEIGHT || windowY > line) // Don't render the window if it's below the screen (or we're not at the scanline yet)
+    state.firstBlock = m_BlockCount;
+    if(dirtyMap.getVRAMGeneration() > m_SnapshotGeneration)
     {
-        return;
+        dirtyMap.forEachDirtyVRAM(m_SnapshotGeneration, [&](u16 address)
+        {
+            Renderer::Block& block = m_Blocks[m_BlockCount++];
+            block.address = address;
+            std::memcpy(block.data.data(), vram + (address - VRAM_START_ADDR), DIRTY_VRAM_BLOCK_SIZE);
+        });
     }
+    state.blockCount = m_BlockCount - state.firstBlock;
 
-    u16 tileDataAddress = bit_functions::get_bit(lcdc, 4) ? TILE_DATA_HIGH : TILE_DATA_LOW;
-    u16 tileMapAddress  = bit_functions::get_bit(lcdc, 6) ? TILE_MAP_HIGH  : TILE_MAP_LOW;
-
-    for(u8 col = 0; col < SCREEN_WIDTH; ++col)
+    state.oamChanged = dirtyMap.isPageDirty(OAM_START_ADDR, m_SnapshotGeneration);
+    if(state.oamChanged)
     {
-        // get the x and y position in the background
-        u8 xPos = col  + windowX;
-        u8 yPos = line + windowY;
-
-        // get the x and y position of the tile within the background
-        u8 tileXPos = xPos / TILE_WIDTH;
-        u8 tileYPos = yPos / TILE_HEIGHT;
-
-        // get the x and y position of the pixel within the tile
-        u8 pixelXPos = xPos % TILE_WIDTH;
-        u8 pixelYPos = yPos % TILE_HEIGHT;
-
-        // get the tile index number and the tile within the tile map
-        u16 tileIndex = tileXPos + tileYPos * TILES_PER_LINE;
-        u8  tileID    = m_Gameboy.read(tileMapAddress + tileIndex);
+        std::memcpy(state.oam.data(), m_Gameboy.getOAM(), state.oam.size());
+    }
 
-        // get the memory offset of the tile in the tile data
-        // if we're using tile data one we need treat the offset as signed from 128
-        u16 tileDataOffset = (tileDataAddress == TILE_DATA_HIGH)
-                           ? (tileID                                   ) * BYTES_PER_TILE
-                           : (static_cast<i8>(tileID) + TILE_ONE_OFFSET) * BYTES_PER_TILE;
+    state.coloursChanged = m_ColoursChanged;
+    if(m_ColoursChanged)
+    {
+        state.colours = m_Colours;
+        m_ColoursChanged = false;
+    }
 
-        // add 2 bytes/line based on the y offset into the tile
-        u16 tileAddress = tileDataAddress + tileDataOffset + 2 * pixelYPos;
+    m_SnapshotGeneration = dirtyMap.getGeneration();
 
-        Colour::GBColour c = getGBColour(pixelXPos, tileAddress);
-        drawPixel(col, line, c);
+    if(m_RenderThread.joinable())
+    {
+        // Release so the render thread sees the snapshot before it sees the count
+        m_Submitted.fetch_add(1, std::memory_order_release);
+        m_Submitted.notify_one();
+    }
+    else
+    {
+        m_Renderer.renderLine(state, &m_Blocks[state.firstBlock]);
     }
 }
 
-void PPU::drawSprites(u8 line)
+void PPU::waitForRenderer()
 {
-    u8 lcdc = m_Gameboy.read(LCD_CONTROL_REGISTER);
-    u8 spriteSize = bit_functions::get_bit(lcdc, 2) ? 2 * SPRITE_HEIGHT : SPRITE_HEIGHT;
-    
-    for (int sprite = 0; sprite < 40; sprite++)
+    if(!m_RenderThread.joinable())
+    {
+        return;
+    }
+
+    u32 submitted = m_Submitted.load(std::memory_order_relaxed);
+    for(u32 completed = m_Completed.load(std::memory_order_acquire); completed != submitted; completed = m_Completed.load(std::memory_order_acquire))
     {
-        u8 spriteIndex = sprite * BYTES_PER_SPRITE;
+        m_Completed.wait(completed, std::memory_order_acquire);
+    }
+}
 
-        // Get the sprite's y position, x position, data address and its attributes
-        u8 spriteYPos      = m_Gameboy.read(OAM_START_ADDR + spriteIndex    ) - SPRITE_Y_OFFSET;
-        u8 spriteXPos      = m_Gameboy.read(OAM_START_ADDR + spriteIndex + 1) - SPRITE_X_OFFSET;
-        u8 tileDataAddress = m_Gameboy.read(OAM_START_ADDR + spriteIndex + 2);
-        u8 attributes      = m_Gameboy.read(OAM_START_ADDR + spriteIndex + 3);
+void PPU::renderLoop()
+{
+    u32 completed = 0;
 
-        bool xFlip      = bit_functions::get_bit(attributes, 5);
-        bool yFlip      = bit_functions::get_bit(attributes, 6);
-        bool bgPriority = bit_functions::get_bit(attributes, 7);
+    while(true)
+    {
+        // Sleep until there's a line to draw
+        m_Submitted.wait(completed, std::memory_order_acquire);
 
-        // Get the pixel in the sprite (and flip it if needed)
-        u8 pixelYPos = line - spriteYPos;
-        if(yFlip)
+        if(m_Stopping.load(std::memory_order_relaxed))
         {
-            pixelYPos = spriteSize - 1 - pixelYPos;
+            return;
         }
 
-        // skip sprites that don't need to be rendered
-        if(line < spriteYPos || line >= spriteYPos + spriteSize) continue;
-
-        // add 2 bytes/line based on the y offset into the tile
-        u16 tileAddress = TILE_DATA_HIGH + tileDataAddress * BYTES_PER_TILE + 2 * pixelYPos;
-
-        // Loop over all the pixels in the sprite
-        for(u8 x = 0; x < SPRITE_WIDTH; ++x)
+        for(u32 submitted = m_Submitted.load(std::memory_order_acquire); completed != submitted; )
         {
-            // And flip the x position if needed
-            u8 pixelXPos = x;
-            if(xFlip)
-            {
-                pixelXPos = SPRITE_WIDTH - 1 - pixelXPos;
-            }
-
-            u8 screenXPos = spriteXPos + x;
+            const Renderer::LineState& state = m_Lines[completed % SCREEN_HEIGHT];
+            m_Renderer.renderLine(state, &m_Blocks[state.firstBlock]);
 
-            // Only render pixels visible on the screen.
-
-            // Less than 0 might continue with the sprite
-            if(screenXPos < 0) continue;
-
-            // Greater than the screen's width would not, so go to the next sprite
-            if(screenXPos >= SCREEN_WIDTH) break;
-
-            Colour::GBColour c = getGBColour(pixelXPos, tileAddress);
-
-            // Don't render white pixels, as they're transparent
-            if (c == Colour::GBColour::WHITE) continue;
-
-            // Don't draw if the background has priority, unless the colour is white
-            if(!bgPriority || getPixel(screenXPos, line) == Colour::GBColour::WHITE)
-            {
-                drawPixel(spriteXPos + x, line, c);
-            }
-       }
+            // Release so the emulation thread sees the line drawn before it sees the count
+            m_Completed.store(++completed, std::memory_order_release);
+            m_Completed.notify_one();
+        }
     }
 }
 
-auto PPU::getGBColour(u8 pixelXPos, u16 tileAddress) const -> Colour::GBColour
+void PPU::setColourScheme(const Colour::Shades& shades)
 {
-    u8 low  = m_Gameboy.read(tileAddress    );
-    u8 high = m_Gameboy.read(tileAddress + 1);
-
-    u8 bit = 7 - pixelXPos;
-    u8 colour = bit_functions::get_bit(low, bit) | (bit_functions::get_bit(high, bit) << 1);
-
-    return static_cast<Colour::GBColour>(colour);
+    waitForRenderer();
+    m_Renderer.setColourScheme(shades);
 }
 
-auto PPU::getScreenColour(Colour::GBColour colour) const -> Colour::ScreenColour
+void PPU::setCGB(bool cgb)
 {
-    // TODO: Colour pallets
+    waitForRenderer();
+
+    m_CGB = cgb;
+    m_ColoursChanged = true;
+    m_Renderer.setCGB(cgb);
 
-    Colour::ScreenColour c;
-    switch(colour)
+    if(cgb)
     {
-        case Colour::GBColour::WHITE:
-            c.red     = 0x9B;
-            c.green   = 0xBC;
-            c.blue    = 0x0F;
-            c.alpha   = 0xFF;
-            break;
-        case Colour::GBColour::LIGHT_GRAY:
-            c.red     = 0x8B;
-            c.green   = 0xAC;
-            c.blue    = 0x0F;
-            c.alpha   = 0xFF;
-            break;
-        case Colour::GBColour::DARK_GRAY:
-            c.red     = 0x30;
-            c.green   = 0x62;
-            c.blue    = 0x30;
-            c.alpha   = 0xFF;
-            break;
-        case Colour::GBColour::BLACK:
-            c.red     = 0x0F;
-            c.green   = 0x38;
-            c.blue    = 0x0F;
-            c.alpha   = 0xFF;
-            break;
-        default:
-            ASSERT(false, "Invalid colour!");
+        setRenderMode(RenderMode::Scanline);
     }
-
-    return c;
-}
-
-void PPU::drawPixel(u8 x, u8 y, Colour::GBColour c)
-{
-    ASSERT((x + y * SCREEN_WIDTH < COLOUR_BUFFER_SIZE), "INVALID PIXEL POSITION! X: " << (int)x << ", Y: " << (int)y << ", Pos: " << (int)((x + y * SCREEN_WIDTH) * 4));
-    
-    m_ColourBuffer[x + y * SCREEN_WIDTH] = c;
-
-    Colour::ScreenColour sc = getScreenColour(c);
-    m_FrameBuffer[(x + y * SCREEN_WIDTH) * 4    ] = sc.red;
-    m_FrameBuffer[(x + y * SCREEN_WIDTH) * 4 + 1] = sc.green;
-    m_FrameBuffer[(x + y * SCREEN_WIDTH) * 4 + 2] = sc.blue;
-    m_FrameBuffer[(x + y * SCREEN_WIDTH) * 4 + 3] = sc.alpha;
-}
-
-auto PPU::getPixel(u8 x, u8 y) const -> Colour::GBColour
-{
-    ASSERT((x + y * SCREEN_WIDTH < COLOUR_BUFFER_SIZE), "INVALID PIXEL POSITION! X: " << (int)x << ", Y: " << (int)y << ", Pos: " << (int)((x + y * SCREEN_WIDTH) * 4));
-    
-    return m_ColourBuffer[x + y * SCREEN_WIDTH];
 }
@@ -3,8 +3,14 @@
 #include "core.hpp"
 
 #include <array>
-#include <functional>
-
+#include <atomic>
+#include <thread>
+
+#include "frame_exchange.hpp"
+#include "frame_hash.hpp"
+#include "pixel_fifo.hpp"
+#include "recorder.hpp"
+#include "renderer.hpp"
 #include "video_defs.hpp"
 
 class Gameboy;
@@ -13,13 +19,73 @@ class PPU
 {
     public:
         PPU(Gameboy& gb);
+        ~PPU();
+
+        /**
+         * @brief Gets the exchange finished frames are published to
+         * 
+         */
+        [[nodiscard]] auto getFrameExchange() -> FrameExchange&;
+
+        /**
+         * @brief Reads one of the LCD registers (0xFF40-0xFF4B, apart from DMA).
+         * LY and STAT are answered from where the PPU is in the frame
+         * 
+         * @param address The register's address
+         * @return The register's value
+         */
+        [[nodiscard]] auto readRegister(u16 address) const -> u8;
+
+        /**
+         * @brief Writes one of the LCD registers (0xFF40-0xFF4B, apart from DMA).
+         * LY is read only, and only the interrupt selects of STAT can be written
+         * 
+         * @param address The register's address
+         * 
+         * @param val The value to write
+         */
+        void writeRegister(u16 address, u8 val);
+
+        /**
+         * @brief Sets how lines are drawn, and so how long mode 3 lasts
+         * 
+         * @param mode The way to draw lines
+         */
+        void setRenderMode(RenderMode mode);
+
+        /**
+         * @brief Sets which frames get rendered. Skipped frames keep
+         * all of their timing and interrupts, but draw nothing, and the
+         * last rendered frame stays in the frame exchange
+         * 
+         * @param skip When to skip rendering
+         * 
+         * @param interval For RenderSkip::Interval, render one frame in this many
+         */
+        void setRenderSkip(RenderSkip skip, u32 interval = 1);
+
+        /**
+         * @brief Asks for the next frame to be rendered, when rendering on demand.
+         * Safe to call from any thread
+         * 
+         */
+        void requestFrame();
 
         /**
-         * @brief Sets the callback function for when the screen is ready to be drawn
+         * @brief Sets the stream the hash of each rendered frame is written to.
+         * Frames are numbered from the first one the PPU finished, whether it was
+         * rendered or not, and frames the LCD was off for aren't counted
          * 
-         * @param callback The callback function to be called
+         * @param stream The stream to write to, or nullptr to stop hashing
          */
-        void setDrawCallback(std::function<void(std::array<u8, FRAME_BUFFER_SIZE> buffer)> callback);
+        void setFrameHashStream(FrameHashStream* stream);
+
+        /**
+         * @brief Sets the recorder each rendered frame is handed to
+         * 
+         * @param recorder The recorder, or nullptr to stop recording
+         */
+        void setRecorder(Recorder* recorder);
 
         /**
          * @brief Emulate the PPU for a specified amount of cycles
@@ -34,76 +100,131 @@ class PPU
         **/
         [[nodiscard]] auto getMode() const -> VideoMode;
 
-    private:
         /**
-         * @brief Draw a background line to the screen
+         * @brief Gets the number of frames finished so far. It goes up as VBlank
+         * starts, and doesn't while the LCD is off
          * 
-         * @param line The background line to draw
          */
-        void drawBackgroundLine(u8 line);
+        [[nodiscard]] __always_inline auto getFrameNumber() const -> u64;
 
         /**
-         * @brief Draw a window line to the screen
+         * @brief Sets the host colours the four shades are drawn with
          * 
-         * @param line The window line to draw
+         * @param shades The colours, from lightest to darkest
          */
-        void drawWindowLine(u8 line);
+        void setColourScheme(const Colour::Shades& shades);
 
         /**
-         * @brief Draw the sprites to the screen
+         * @brief Sets whether the PPU runs in CGB mode, with banked VRAM,
+         * tile attributes and palette ram. CGB mode always draws by scanline
          * 
+         * @param cgb Whether the game runs in CGB mode
          */
-        void drawSprites(u8 line);
+        void setCGB(bool cgb);
 
+    private:
         /**
-         * @brief Get the gameboy colour of a pixel within a tile
-         * 
-         * @param pixelXPos The x position of the pixel within
-         * the tile
+         * @brief Turns the LCD on or off (LCDC bit 7). While it's off
+         * the PPU sits idle with LY at 0, and turning it back on
+         * starts a new frame from line 0
          * 
-         * @param tileAddress The address of the tile to get the
-         * colour information from
-         * @return The Gameboy colour at the x position of the tile
+         * @param enabled Whether the LCD is on
          */
-        auto getGBColour(u8 pixelXPos, u16 tileAddress) const -> Colour::GBColour;
+        void setEnabled(bool enabled);
 
         /**
-         * @brief Convert a GB Colour into a screen colour
+         * @brief Writes to CGB palette ram through one of the palette data registers,
+         * moving the index on afterwards if it's set to auto increment
          * 
-         * @param colour The colour of the gb colour to convert into a screen colour
-         * @return The screen colour at the pixel
+         * @param index The palette index register (BCPS or OCPS)
+         * 
+         * @param offset Where the palettes start in palette ram
+         * 
+         * @param val The value to write
          */
-        auto getScreenColour(Colour::GBColour colour) const -> Colour::ScreenColour;
+        void writePaletteData(u8& index, u8 offset, u8 val);
 
         /**
-         * @brief Draw a specified pixel at position (x, y) with
-         * colour c
+         * @brief Decides whether the frame that's starting gets rendered
          * 
-         * @param x The x coordinate of the pixel
+         */
+        [[nodiscard]] auto shouldRenderFrame() -> bool;
+
+        /**
+         * @brief Takes a snapshot of the registers, and whatever VRAM and OAM
+         * were written since the line before, and hands it to the renderer
          * 
-         * @param y The y coordinate of the pixel
-         *
-         * @param c The colour of the pixel
+         * @param line The line that's starting to draw
          */
-        void drawPixel(u8 x, u8 y, Colour::GBColour);
+        void submitLine(u8 line);
 
         /**
-         * @brief Get the colour of a pixel on the screen
+         * @brief Waits until the renderer has drawn every line handed to it
          * 
-         * @param x The x coordinate of the pixel to get
+         */
+        void waitForRenderer();
+
+        /**
+         * @brief Draws lines on the render thread as they're handed over
          * 
-         * @param y The y coordinate of the pixel to get
-         * @return The Gameboy colour at the pixel
          */
-        [[nodiscard]] auto getPixel(u8 x, u8 y) const -> Colour::GBColour;
+        void renderLoop();
     private:
+        static constexpr u32 VRAM_BLOCKS = VRAM_BANK_COUNT * VRAM_BANK_SIZE / DIRTY_VRAM_BLOCK_SIZE;
+
+        // Bits of the palette index registers
+        static constexpr u8 PALETTE_INDEX_MASK    = 0x3F;
+        static constexpr u8 PALETTE_AUTO_INC_BIT  = 7;
+
         Gameboy& m_Gameboy;
 
-        std::array<Colour::GBColour, COLOUR_BUFFER_SIZE> m_ColourBuffer {{}};
-        std::array<u8,               FRAME_BUFFER_SIZE>  m_FrameBuffer  {{}};
-        std::function<void(std::array<u8, FRAME_BUFFER_SIZE> buffer)> m_DrawCallback;
+        VideoRegisters m_Registers;
+
+        // CGB palette ram, background palettes then object palettes, and the colours it holds
+        std::array<u8, 2 * CGB_PALETTE_RAM_SIZE> m_PaletteRAM;
+        Colour::CGBPalette m_Colours;
+        bool m_ColoursChanged;
+        bool m_CGB;
+
+        FrameExchange m_Frames;
+        Renderer m_Renderer;
+        PixelFIFO m_PixelFIFO;
+        RenderMode m_RenderMode;
+
+        // The lines handed to the renderer this frame, and the VRAM written before each of them
+        std::array<Renderer::LineState, SCREEN_HEIGHT> m_Lines;
+        std::array<Renderer::Block, 4 * VRAM_BLOCKS> m_Blocks;
+        u32 m_BlockCount;
+        u64 m_SnapshotGeneration;
+
+        // Lines are counted as they're handed over and drawn, so each side can wait on the other
+        std::thread m_RenderThread;
+        std::atomic<u32> m_Submitted;
+        std::atomic<u32> m_Completed;
+        std::atomic<bool> m_Stopping;
 
         VideoMode m_Mode;
+        bool m_Enabled;
         u16 m_Cycles;
+        u16 m_HBlankCycles;
         u8 m_Line;
+        u8 m_WindowLine;
+
+        RenderSkip m_RenderSkip;
+        u32 m_RenderInterval;
+        u32 m_FramesSinceRender;
+        std::atomic<bool> m_FrameRequested;
+        bool m_Rendering;
+
+        FrameHashStream* m_HashStream;
+        u64 m_FrameNumber;
+
+        Recorder* m_Recorder;
 };
+
+//--------------------------  Inline function implementations --------------------------//
+
+__always_inline auto PPU::getFrameNumber() const -> u64
+{
+    return m_FrameNumber;
+}
@@ -0,0 +1,240 @@
+#include "core.hpp"
+
+#include "recorder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static constexpr char Y4M_FRAME_HEADER[] = "FRAME\n";
+
+/**
+ * @brief Converts RGBA pixels to planes of BT.601 YUV
+ * 
+ * @param rgba The pixels
+ * 
+ * @param yuv Where to write the Y plane, followed by the U and V planes
+ */
+static void toYUV(const u8* rgba, u8* yuv)
+{
+    u8* y = yuv;
+    u8* u = y + COLOUR_BUFFER_SIZE;
+    u8* v = u + COLOUR_BUFFER_SIZE;
+
+    for(u32 pixel = 0; pixel < COLOUR_BUFFER_SIZE; ++pixel, rgba += 4)
+    {
+        i32 red = rgba[0], green = rgba[1], blue = rgba[2];
+
+        y[pixel] = static_cast<u8>((( 66 * red + 129 * green +  25 * blue + 128) >> 8) + 16);
+        u[pixel] = static_cast<u8>(((-38 * red -  74 * green + 112 * blue + 128) >> 8) + 128);
+        v[pixel] = static_cast<u8>(((112 * red -  94 * green -  18 * blue + 128) >> 8) + 128);
+    }
+}
+
+/**
+ * @brief Converts colour indices, as left by the renderer, to the shades or CGB colours they're drawn with
+ * 
+ * @param indices The colour indices
+ * 
+ * @param palettes The palettes each line was drawn with
+ * 
+ * @param cgb Whether the frame was drawn in CGB mode
+ * 
+ * @param out Where to write a byte per pixel
+ */
+static void toIndexed(const Colour::GBColour* indices, const std::array<u64, SCREEN_HEIGHT>& palettes, bool cgb, u8* out)
+{
+    // CGB indices are already the palette and colour
+    if(cgb)
+    {
+        std::memcpy(out, indices, COLOUR_BUFFER_SIZE);
+        return;
+    }
+
+    for(u32 line = 0; line < SCREEN_HEIGHT; ++line)
+    {
+        // Each DMG line carries BGP, OBP0 and OBP1, one byte each, and its pixels are tagged with which they went through
+        for(u32 x = 0; x < SCREEN_WIDTH; ++x, ++indices, ++out)
+        {
+            u8 palette = static_cast<u8>(palettes[line] >> ((*indices >> Colour::PALETTE_SHIFT) * 8));
+            *out = (palette >> ((*indices & Colour::COLOUR_MASK) * 2)) & Colour::COLOUR_MASK;
+        }
+    }
+}
+
+Recorder::Recorder()
+    : m_Stream(nullptr), m_Format(RecordFormat::Y4M), m_Policy(RecordPolicy::Drop),
+      m_Submitted(0), m_Completed(0), m_Stopping(false), m_Dropped(0)
+{}
+
+Recorder::~Recorder()
+{
+    stop();
+}
+
+auto Recorder::start(const std::string& path, RecordFormat format, RecordPolicy policy, u32 frameInterval) -> bool
+{
+    stop();
+
+    if(path == "-")
+    {
+        m_Stream = &std::cout;
+    }
+    else
+    {
+        m_File.open(path, std::ios::binary);
+        if(!m_File)
+        {
+            ERROR("Could not open '" << path << "' to record to!");
+            return false;
+        }
+
+        m_Stream = &m_File;
+    }
+
+    m_Format  = format;
+    m_Policy  = policy;
+    m_Dropped = 0;
+
+    m_Slots.resize(SLOTS);
+    switch(m_Format)
+    {
+        case RecordFormat::Y4M:
+            m_Output.resize(sizeof(Y4M_FRAME_HEADER) - 1 + 3 * COLOUR_BUFFER_SIZE);
+            std::memcpy(m_Output.data(), Y4M_FRAME_HEADER, sizeof(Y4M_FRAME_HEADER) - 1);
+
+            // The Gameboy runs at 4194304 / 70224 frames per second, a little under 60
+            *m_Stream << "YUV4MPEG2 W" << static_cast<u32>(SCREEN_WIDTH) << " H" << static_cast<u32>(SCREEN_HEIGHT)
+                      << " F" << CLOCK_SPEED << ":" << CYCLES_PER_FRAME * std::max<u32>(frameInterval, 1) << " Ip A1:1 C444\n";
+            break;
+        case RecordFormat::Indexed:
+            m_Output.resize(COLOUR_BUFFER_SIZE);
+            break;
+        default:
+            break;
+    }
+
+    m_Stopping.store(false, std::memory_order_relaxed);
+    m_Thread = std::thread(&Recorder::writeLoop, this);
+
+    return true;
+}
+
+void Recorder::stop()
+{
+    if(!m_Thread.joinable())
+    {
+        return;
+    }
+
+    // Let the writer finish every frame it has, then wake it up to stop
+    u32 submitted = m_Submitted.load(std::memory_order_relaxed);
+    for(u32 completed = m_Completed.load(std::memory_order_acquire); completed != submitted; completed = m_Completed.load(std::memory_order_acquire))
+    {
+        m_Completed.wait(completed, std::memory_order_acquire);
+    }
+
+    m_Stopping.store(true, std::memory_order_relaxed);
+    m_Submitted.fetch_add(1, std::memory_order_release);
+    m_Submitted.notify_one();
+    m_Thread.join();
+
+    m_Submitted.store(0, std::memory_order_relaxed);
+    m_Completed.store(0, std::memory_order_relaxed);
+
+    m_Stream->flush();
+    m_Stream = nullptr;
+    if(m_File.is_open())
+    {
+        m_File.close();
+    }
+
+    m_Slots.clear();
+    m_Slots.shrink_to_fit();
+
+    if(m_Dropped > 0)
+    {
+        WARN("Dropped " << m_Dropped << " frames the recording couldn't keep up with.");
+    }
+}
+
+void Recorder::submit(const FrameExchange::Frame& frame, const Colour::GBColour* indices, const std::array<u64, SCREEN_HEIGHT>& palettes, bool cgb)
+{
+    if(!m_Stream)
+    {
+        return;
+    }
+
+    // Wait for the writer to free up a slot, or give up on the frame
+    u32 submitted = m_Submitted.load(std::memory_order_relaxed);
+    for(u32 completed = m_Completed.load(std::memory_order_acquire); submitted - completed == SLOTS; completed = m_Completed.load(std::memory_order_acquire))
+    {
+        if(m_Policy == RecordPolicy::Drop)
+        {
+            m_Dropped++;
+            return;
+        }
+
+        m_Completed.wait(completed, std::memory_order_acquire);
+    }
+
+    // Only copy what the format is made from
+    Slot& slot = m_Slots[submitted % SLOTS];
+    if(m_Format == RecordFormat::Indexed)
+    {
+        std::memcpy(slot.indices.data(), indices, COLOUR_BUFFER_SIZE);
+        slot.palettes = palettes;
+        slot.cgb = cgb;
+    }
+    else
+    {
+        slot.rgba = frame;
+    }
+
+    // Release so the writer sees the slot filled before it sees the count
+    m_Submitted.store(submitted + 1, std::memory_order_release);
+    m_Submitted.notify_one();
+}
+
+void Recorder::writeLoop()
+{
+    u32 completed = 0;
+
+    while(true)
+    {
+        // Sleep until there's a frame to write
+        m_Submitted.wait(completed, std::memory_order_acquire);
+
+        if(m_Stopping.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        for(u32 submitted = m_Submitted.load(std::memory_order_acquire); completed != submitted; )
+        {
+            write(m_Slots[completed % SLOTS]);
+
+            // Release so the emulation thread only reuses the slot once it's been written
+            m_Completed.store(++completed, std::memory_order_release);
+            m_Completed.notify_one();
+        }
+    }
+}
+
+void Recorder::write(const Slot& slot)
+{
+    switch(m_Format)
+    {
+        case RecordFormat::Y4M:
+            toYUV(slot.rgba.data(), m_Output.data() + sizeof(Y4M_FRAME_HEADER) - 1);
+            m_Stream->write(reinterpret_cast<const char*>(m_Output.data()), m_Output.size());
+            break;
+        case RecordFormat::RGBA:
+            m_Stream->write(reinterpret_cast<const char*>(slot.rgba.data()), slot.rgba.size());
+            break;
+        case RecordFormat::Indexed:
+            toIndexed(slot.indices.data(), slot.palettes, slot.cgb, m_Output.data());
+            m_Stream->write(reinterpret_cast<const char*>(m_Output.data()), m_Output.size());
+            break;
+    }
+}
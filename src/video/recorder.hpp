@@ -0,0 +1,124 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_exchange.hpp"
+#include "video_defs.hpp"
+
+/**
+    Records every rendered frame to a file, or stdout for piping
+    into ffmpeg, without holding up the emulation.
+
+    The PPU hands each frame over as it finishes, by copying it into
+    one of a small ring of slots, and a writer thread converts the
+    slots to the output format and writes them out. Nothing is
+    converted on the emulation thread. When the writer falls behind
+    and every slot is full, the policy decides whether the frame is
+    dropped, or the emulation waits for a slot.
+
+    Frames are written at the screen's own resolution, as one of:
+    - Y4M, as 4:4:4 YUV with the Gameboy's frame rate in the header
+    - Raw RGBA, 4 bytes per pixel
+    - Indexed, a byte per pixel. DMG frames hold the shade of each
+      pixel, from 0 (lightest) to 3 (darkest), and CGB frames hold
+      each pixel's palette * 4 + colour, from 0 to 63
+**/
+
+enum class RecordFormat
+{
+    Y4M,
+    RGBA,
+    Indexed
+};
+
+enum class RecordPolicy
+{
+    Drop,   // Drop frames the writer can't keep up with
+    Wait    // Hold up the emulation until the writer has room
+};
+
+class Recorder
+{
+    public:
+        Recorder();
+        ~Recorder();
+
+        /**
+         * @brief Starts recording to a file
+         * 
+         * @param path The path to write to, or "-" for stdout
+         * 
+         * @param format The format to write frames in
+         * 
+         * @param policy What to do with frames when the writer falls behind
+         * 
+         * @param frameInterval How many of the Gameboy's frames pass for each one
+         * recorded, when frames are being skipped, for the Y4M frame rate
+         * @return Whether the file could be opened
+         */
+        auto start(const std::string& path, RecordFormat format, RecordPolicy policy, u32 frameInterval = 1) -> bool;
+
+        /**
+         * @brief Writes out every frame still waiting, and stops recording
+         * 
+         */
+        void stop();
+
+        /**
+         * @brief Hands a finished frame over to be written
+         * 
+         * @param frame The frame's pixels
+         * 
+         * @param indices The frame's colour indices, as left by the renderer
+         * 
+         * @param palettes The palettes each line was drawn with, as left by the renderer
+         * 
+         * @param cgb Whether the frame was drawn in CGB mode
+         */
+        void submit(const FrameExchange::Frame& frame, const Colour::GBColour* indices, const std::array<u64, SCREEN_HEIGHT>& palettes, bool cgb);
+    private:
+        static constexpr u32 SLOTS = 8;
+
+        struct Slot
+        {
+            FrameExchange::Frame rgba;
+            std::array<Colour::GBColour, COLOUR_BUFFER_SIZE> indices;
+            std::array<u64, SCREEN_HEIGHT> palettes;
+            bool cgb;
+        };
+
+        /**
+         * @brief Converts and writes out frames as they're handed over
+         * 
+         */
+        void writeLoop();
+
+        /**
+         * @brief Converts a frame to the output format, and writes it out
+         * 
+         * @param slot The frame
+         */
+        void write(const Slot& slot);
+    private:
+        std::ofstream m_File;
+        std::ostream* m_Stream;
+        RecordFormat m_Format;
+        RecordPolicy m_Policy;
+
+        std::vector<Slot> m_Slots;
+        std::vector<u8>   m_Output;
+
+        // Frames are counted as they're handed over and written, so each side can wait on the other
+        std::thread m_Thread;
+        std::atomic<u32> m_Submitted;
+        std::atomic<u32> m_Completed;
+        std::atomic<bool> m_Stopping;
+        u64 m_Dropped;
+};
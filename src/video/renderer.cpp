@@ -0,0 +1,472 @@
+#include "core.hpp"
+
+#include "renderer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "frame_hash.hpp"
+
+/**
+ * @brief Mixes a value into a signature
+ * 
+ * @param signature The signature so far
+ * 
+ * @param value The value to mix in
+ * @return The new signature
+ */
+static __always_inline auto combine(u64 signature, u64 value) -> u64
+{
+    signature = (signature ^ value) * 0x9E3779B97F4A7C15;
+    return signature ^ (signature >> 32);
+}
+
+Renderer::Renderer(FrameExchange& frames)
+    : m_Frames(frames), m_VRAM({}), m_OAM({}), m_ColourBuffer({}), m_PaletteRegisters({}), m_Palette({}), m_ShadePalette({}),
+      m_CGBPalette({}), m_CGB(false),
+      m_LineSignatures({}), m_BufferSignatures({}), m_PaletteGeneration(0), m_FrameChanged(false), m_LinePalettes({}), m_CGBPaletteHash(0)
+{
+    setColourScheme(Colour::GREEN_SHADES);
+}
+
+auto Renderer::isWindowVisible(const LineState& state) -> bool
+{
+    if(!bit_functions::get_bit(state.lcdc, 5)) // Window not rendering
+    {
+        return false;
+    }
+
+    // window x scroll has an offset of 7, so the window can start partly off the left of the screen
+    if(state.windowX - WINDOW_X_OFFSET >= SCREEN_WIDTH) // Don't render the window if it's to the right of the screen
+    {
+        return false;
+    }
+
+    // Don't render the window if it's below the screen (or we're not at the scanline yet)
+    return state.windowY < SCREEN_HEIGHT && state.windowY <= state.line;
+}
+
+void Renderer::renderLine(const LineState& state, const Block* blocks)
+{
+    // Catch up on the memory written to since the last line
+    for(u32 i = 0; i < state.blockCount; ++i)
+    {
+        std::memcpy(&m_VRAM[blocks[i].address - VRAM_START_ADDR], blocks[i].data.data(), DIRTY_VRAM_BLOCK_SIZE);
+        m_DirtyMap.markVRAM(blocks[i].address);
+    }
+
+    if(state.oamChanged)
+    {
+        m_OAM = state.oam;
+        m_DirtyMap.markPage(OAM_START_ADDR);
+    }
+
+    if(m_CGB)
+    {
+        drawLine<true>(state);
+    }
+    else
+    {
+        drawLine<false>(state);
+    }
+}
+
+template <bool CGB>
+void Renderer::drawLine(const LineState& state)
+{
+    if constexpr(CGB)
+    {
+        // The colours come ready to use, whenever palette ram was written
+        if(state.coloursChanged)
+        {
+            m_CGBPalette = state.colours;
+            m_CGBPaletteHash = FrameHash::hash(reinterpret_cast<const u8*>(m_CGBPalette.data()), sizeof(m_CGBPalette));
+            m_PaletteGeneration++;
+        }
+
+        m_LinePalettes[state.line] = m_CGBPaletteHash;
+    }
+    else
+    {
+        for(u8 palette = 0; palette < state.palettes.size(); ++palette)
+        {
+            if(state.palettes[palette] != m_PaletteRegisters[palette])
+            {
+                setPalette(static_cast<Colour::PaletteID>(palette), state.palettes[palette]);
+            }
+        }
+
+        m_LinePalettes[state.line] = state.palettes[0] | (state.palettes[1] << 8) | (state.palettes[2] << 16);
+    }
+
+    // Pick up any tiles, tile map entries and sprites that changed
+    m_DirtyMap.sync();
+    m_TileCache.update(m_VRAM.data(), m_DirtyMap);
+    m_LayerCache.update<CGB>(m_VRAM.data(), m_DirtyMap, m_TileCache, bit_functions::get_bit(state.lcdc, 4));
+    m_SpriteLists.update(m_OAM.data(), m_DirtyMap, bit_functions::get_bit(state.lcdc, 2) ? 2 * SPRITE_HEIGHT : SPRITE_HEIGHT, !CGB);
+
+    // Only draw the line again if something it's drawn from has changed since last frame
+    u64 signature = getLineSignature<CGB>(state);
+    if(signature != m_LineSignatures[state.line])
+    {
+        drawBackgroundLine(state);
+        drawWindowLine(state);
+        drawSprites<CGB>(state);
+
+        if constexpr(CGB)
+        {
+            // The sprites are done with the background's priority bits, which would throw off the lookup
+            Colour::GBColour* line = &m_ColourBuffer[state.line * SCREEN_WIDTH];
+            for(u8 x = 0; x < SCREEN_WIDTH; ++x)
+            {
+                line[x] = static_cast<Colour::GBColour>(line[x] & ~(1 << Colour::CGB_PRIORITY_BIT));
+            }
+        }
+
+        m_LineSignatures[state.line] = signature;
+        m_FrameChanged = true;
+    }
+
+    // The line is finished, so turn its colour indices into pixels in one pass,
+    // through the palettes as they are now so mid frame palette changes show up.
+    // The frame buffers rotate, so this one may hold the line from a few frames ago
+    u64& converted = m_BufferSignatures[m_Frames.getBackIndex()][state.line];
+    if(signature != converted)
+    {
+        u32 lineStart = state.line * SCREEN_WIDTH;
+        if constexpr(CGB)
+        {
+            Colour::toRGBA(&m_ColourBuffer[lineStart], &m_Frames.getBackBuffer()[lineStart * 4], SCREEN_WIDTH, m_CGBPalette);
+        }
+        else
+        {
+            Colour::toRGBA(&m_ColourBuffer[lineStart], &m_Frames.getBackBuffer()[lineStart * 4], SCREEN_WIDTH, m_Palette);
+        }
+
+        converted = signature;
+    }
+}
+
+void Renderer::presentLine(u8 line, const std::array<u8, SCREEN_WIDTH>& shades)
+{
+    u64 signature = 0;
+    for(u32 x = 0; x < SCREEN_WIDTH; x += sizeof(u64))
+    {
+        u64 pixels;
+        std::memcpy(&pixels, &shades[x], sizeof(pixels));
+        signature = combine(signature, pixels);
+    }
+    signature |= 1;
+
+    if(signature != m_LineSignatures[line])
+    {
+        m_LineSignatures[line] = signature;
+        m_FrameChanged = true;
+    }
+
+    // The shades have the palettes applied already, so the line's palettes map each shade to itself
+    std::memcpy(&m_ColourBuffer[line * SCREEN_WIDTH], shades.data(), SCREEN_WIDTH);
+    m_LinePalettes[line] = IDENTITY_PALETTES;
+
+    u64& converted = m_BufferSignatures[m_Frames.getBackIndex()][line];
+    if(signature != converted)
+    {
+        const Colour::GBColour* indices = reinterpret_cast<const Colour::GBColour*>(shades.data());
+        Colour::toRGBA(indices, &m_Frames.getBackBuffer()[line * SCREEN_WIDTH * 4], SCREEN_WIDTH, m_ShadePalette);
+
+        converted = signature;
+    }
+}
+
+void Renderer::clear()
+{
+    // The CGB's screen goes white, rather than the lightest shade
+    const Colour::ScreenColour& blank = m_CGB ? Colour::GREY_SHADES[Colour::GBColour::WHITE] : m_Shades[Colour::GBColour::WHITE];
+
+    FrameExchange::Frame& frame = m_Frames.getBackBuffer();
+    for(u32 pixel = 0; pixel < COLOUR_BUFFER_SIZE; ++pixel)
+    {
+        std::memcpy(&frame[pixel * 4], &blank, sizeof(Colour::ScreenColour));
+    }
+
+    m_BufferSignatures[m_Frames.getBackIndex()].fill(INVALID_SIGNATURE);
+    m_LineSignatures.fill(INVALID_SIGNATURE);
+    m_FrameChanged = false;
+}
+
+auto Renderer::finishFrame() -> bool
+{
+    bool changed = m_FrameChanged;
+    m_FrameChanged = false;
+    return changed;
+}
+
+auto Renderer::getFrameHash() const -> u64
+{
+    u64 palettes = FrameHash::hash(reinterpret_cast<const u8*>(m_LinePalettes.data()), sizeof(m_LinePalettes));
+    return FrameHash::hash(reinterpret_cast<const u8*>(m_ColourBuffer.data()), sizeof(m_ColourBuffer), palettes);
+}
+
+auto Renderer::getColourBuffer() const -> const Colour::GBColour*
+{
+    return m_ColourBuffer.data();
+}
+
+auto Renderer::getLinePalettes() const -> const std::array<u64, SCREEN_HEIGHT>&
+{
+    return m_LinePalettes;
+}
+
+void Renderer::setColourScheme(const Colour::Shades& shades)
+{
+    m_Shades = shades;
+
+    for(u8 shade = 0; shade < m_Shades.size(); ++shade)
+    {
+        m_ShadePalette[shade] = Colour::toPixel(m_Shades[shade]);
+    }
+
+    for(u8 palette = 0; palette < m_PaletteRegisters.size(); ++palette)
+    {
+        setPalette(static_cast<Colour::PaletteID>(palette), m_PaletteRegisters[palette]);
+    }
+}
+
+void Renderer::setCGB(bool cgb)
+{
+    m_CGB = cgb;
+
+    // Nothing drawn so far was drawn the same way
+    m_LineSignatures.fill(INVALID_SIGNATURE);
+    for(auto& signatures : m_BufferSignatures)
+    {
+        signatures.fill(INVALID_SIGNATURE);
+    }
+}
+
+template <bool CGB>
+auto Renderer::getLineSignature(const LineState& state) const -> u64
+{
+    u64 signature = combine(state.lcdc | (state.scrollX << 8) | (state.scrollY << 16), m_PaletteGeneration);
+
+    u16 backgroundMap = bit_functions::get_bit(state.lcdc, 3) ? TILE_MAP_HIGH : TILE_MAP_LOW;
+    signature = combine(signature, m_LayerCache.getLineGeneration(backgroundMap, state.line + state.scrollY));
+
+    if(isWindowVisible(state))
+    {
+        u16 windowMap = bit_functions::get_bit(state.lcdc, 6) ? TILE_MAP_HIGH : TILE_MAP_LOW;
+
+        signature = combine(signature, state.windowX | (state.windowLine << 8));
+        signature = combine(signature, m_LayerCache.getLineGeneration(windowMap, state.windowLine));
+    }
+
+    if(bit_functions::get_bit(state.lcdc, 1))
+    {
+        const SpriteLists::Line& sprites = m_SpriteLists.getLine(state.line);
+
+        for(u8 i = 0; i < sprites.count; ++i)
+        {
+            const u8* sprite = &m_OAM[sprites.sprites[i] * BYTES_PER_SPRITE];
+
+            u32 attributes;
+            std::memcpy(&attributes, sprite, sizeof(attributes));
+
+            // Tall sprites are drawn from both tiles of the pair
+            u16 tile = sprite[2];
+            if constexpr(CGB)
+            {
+                if(bit_functions::get_bit(sprite[3], 3)) // Tile from bank 1
+                {
+                    tile += TILE_COUNT;
+                }
+            }
+
+            signature = combine(signature, attributes);
+            signature = combine(signature, m_TileCache.getGeneration(tile));
+            signature = combine(signature, m_TileCache.getGeneration(tile ^ 1));
+        }
+    }
+
+    // Keep the lowest bit set, so no line ever matches INVALID_SIGNATURE
+    return signature | 1;
+}
+
+void Renderer::setPalette(Colour::PaletteID palette, u8 value)
+{
+    m_PaletteRegisters[static_cast<u8>(palette)] = value;
+
+    // Each two bits of the register pick the shade of a colour index
+    bool changed = false;
+    for(u8 colour = 0; colour < 4; ++colour)
+    {
+        u8 shade = (value >> (colour * 2)) & Colour::COLOUR_MASK;
+        u32& entry = m_Palette[Colour::tag(static_cast<Colour::GBColour>(colour), palette)];
+
+        u32 pixel = Colour::toPixel(m_Shades[shade]);
+        changed |= entry != pixel;
+        entry = pixel;
+    }
+
+    // Games often write the same palette every frame, which shouldn't redraw anything
+    if(changed)
+    {
+        m_PaletteGeneration++;
+    }
+}
+
+void Renderer::drawBackgroundLine(const LineState& state)
+{
+    u16 tileMapAddress = bit_functions::get_bit(state.lcdc, 3) ? TILE_MAP_HIGH : TILE_MAP_LOW;
+
+    const Colour::GBColour* layerLine = m_LayerCache.getLine(tileMapAddress, state.line + state.scrollY);
+
+    // The background wraps around, so the line may need to be copied in two parts
+    u8 width = std::min<u16>(SCREEN_WIDTH, BG_WIDTH - state.scrollX);
+
+    drawPixels(0, state.line, layerLine + state.scrollX, width);
+    if(width < SCREEN_WIDTH)
+    {
+        drawPixels(width, state.line, layerLine, SCREEN_WIDTH - width);
+    }
+}
+
+void Renderer::drawWindowLine(const LineState& state)
+{
+    if(!isWindowVisible(state))
+    {
+        return;
+    }
+
+    // window x scroll has an offset of 7, so the window can start partly off the left of the screen
+    int windowX = state.windowX - WINDOW_X_OFFSET;
+
+    u16 tileMapAddress = bit_functions::get_bit(state.lcdc, 6) ? TILE_MAP_HIGH : TILE_MAP_LOW;
+
+    const Colour::GBColour* layerLine = m_LayerCache.getLine(tileMapAddress, state.windowLine);
+
+    u8 screenXPos = std::max(windowX, 0);
+    u8 hidden     = screenXPos - windowX; // window pixels off the left of the screen
+
+    drawPixels(screenXPos, state.line, layerLine + hidden, SCREEN_WIDTH - screenXPos);
+}
+
+template <bool CGB>
+void Renderer::drawSprites(const LineState& state)
+{
+    if(!bit_functions::get_bit(state.lcdc, 1)) // Sprites not rendering
+    {
+        return;
+    }
+
+    u8 line       = state.line;
+    u8 spriteSize = bit_functions::get_bit(state.lcdc, 2) ? 2 * SPRITE_HEIGHT : SPRITE_HEIGHT;
+
+    const SpriteLists::Line& sprites = m_SpriteLists.getLine(line);
+
+    // Pixels already taken by a higher priority sprite, even one hidden behind the background
+    std::array<bool, SCREEN_WIDTH> claimed {};
+
+    for(u8 i = 0; i < sprites.count; ++i)
+    {
+        const u8* sprite = &m_OAM[sprites.sprites[i] * BYTES_PER_SPRITE];
+
+        // Get the sprite's y position, x position, data address and its attributes
+        // Sprites can hang off the top and left of the screen, so keep the positions signed
+        int spriteYPos  = sprite[0] - SPRITE_Y_OFFSET;
+        int spriteXPos  = sprite[1] - SPRITE_X_OFFSET;
+        u8  tileID      = sprite[2];
+        u8  attributes  = sprite[3];
+
+        Colour::PaletteID palette = bit_functions::get_bit(attributes, 4) ? Colour::PaletteID::Object1 : Colour::PaletteID::Object0;
+        bool xFlip      = bit_functions::get_bit(attributes, 5);
+        bool yFlip      = bit_functions::get_bit(attributes, 6);
+        bool bgPriority = bit_functions::get_bit(attributes, 7);
+
+        // Tall sprites ignore the lowest bit of the tile index
+        if(spriteSize != SPRITE_HEIGHT)
+        {
+            bit_functions::clear_bit(tileID, 0);
+        }
+
+        u16 tile = tileID;
+        if constexpr(CGB)
+        {
+            if(bit_functions::get_bit(attributes, 3)) // Tile from bank 1
+            {
+                tile += TILE_COUNT;
+            }
+        }
+
+        // Get the row in the sprite (and flip it if needed)
+        u8 pixelYPos = line - spriteYPos;
+        if(yFlip)
+        {
+            pixelYPos = spriteSize - 1 - pixelYPos;
+        }
+
+        // Tall sprites carry on into the next tile
+        const Colour::GBColour* pixels = m_TileCache.getRow(tile + pixelYPos / TILE_HEIGHT, pixelYPos % TILE_HEIGHT, xFlip);
+
+        // Loop over all the pixels in the sprite
+        for(u8 x = 0; x < SPRITE_WIDTH; ++x)
+        {
+            int screenXPos = spriteXPos + x;
+
+            // Only render pixels visible on the screen.
+
+            // Less than 0 might continue with the sprite
+            if(screenXPos < 0) continue;
+
+            // Greater than the screen's width would not, so go to the next sprite
+            if(screenXPos >= SCREEN_WIDTH) break;
+
+            Colour::GBColour c = pixels[x];
+
+            // Colour index 0 is transparent, whatever shade the palette gives it
+            if (c == Colour::GBColour::WHITE || claimed[screenXPos]) continue;
+
+            claimed[screenXPos] = true;
+
+            if constexpr(CGB)
+            {
+                // Either the sprite or the background's tile can put the background on top, unless
+                // LCDC bit 0 is clear, which puts every sprite on top. Colour 0 is still always behind
+                Colour::GBColour background = getPixel(screenXPos, line);
+                bool behind = (background & Colour::COLOUR_MASK) != Colour::GBColour::WHITE
+                           && (bgPriority || bit_functions::get_bit(background, Colour::CGB_PRIORITY_BIT))
+                           && bit_functions::get_bit(state.lcdc, 0);
+
+                if(!behind)
+                {
+                    drawPixel(screenXPos, line, Colour::tag(c, static_cast<u8>(Colour::CGB_OBJECT_PALETTES + (attributes & 0x07))));
+                }
+            }
+            // Don't draw if the background has priority, unless the colour is white
+            else if(!bgPriority || getPixel(screenXPos, line) == Colour::GBColour::WHITE)
+            {
+                drawPixel(screenXPos, line, Colour::tag(c, palette));
+            }
+       }
+    }
+}
+
+void Renderer::drawPixels(u8 x, u8 y, const Colour::GBColour* pixels, u8 count)
+{
+    ASSERT((x + count <= SCREEN_WIDTH && y < SCREEN_HEIGHT), "INVALID PIXEL RUN! X: " << (int)x << ", Y: " << (int)y << ", Count: " << (int)count);
+
+    std::memcpy(&m_ColourBuffer[x + y * SCREEN_WIDTH], pixels, count);
+}
+
+void Renderer::drawPixel(u8 x, u8 y, Colour::GBColour c)
+{
+    ASSERT((x + y * SCREEN_WIDTH < COLOUR_BUFFER_SIZE), "INVALID PIXEL POSITION! X: " << (int)x << ", Y: " << (int)y << ", Pos: " << (int)((x + y * SCREEN_WIDTH) * 4));
+
+    m_ColourBuffer[x + y * SCREEN_WIDTH] = c;
+}
+
+auto Renderer::getPixel(u8 x, u8 y) const -> Colour::GBColour
+{
+    ASSERT((x + y * SCREEN_WIDTH < COLOUR_BUFFER_SIZE), "INVALID PIXEL POSITION! X: " << (int)x << ", Y: " << (int)y << ", Pos: " << (int)((x + y * SCREEN_WIDTH) * 4));
+
+    return m_ColourBuffer[x + y * SCREEN_WIDTH];
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+
+#include "colour_convert.hpp"
+#include "dirty_map.hpp"
+#include "frame_exchange.hpp"
+#include "layer_cache.hpp"
+#include "sprite_lists.hpp"
+#include "tile_cache.hpp"
+#include "video_defs.hpp"
+
+/**
+    Draws lines of the screen into the frame exchange, from snapshots
+    of the PPU's registers taken as each line started drawing.
+
+    The renderer keeps its own copy of VRAM and OAM, which each
+    snapshot brings up to date with whatever was written since the
+    line before. It never reads the emulator's memory, so it can run
+    on another thread some lines behind the CPU, and still draw every
+    line with exactly the memory and registers it had.
+
+    Lines are drawn by a version of the renderer specialised for DMG
+    or CGB mode at compile time, so DMG games never pay for attributes,
+    banks or the bigger palette table.
+**/
+
+class Renderer
+{
+    public:
+        struct Block
+        {
+            u16 address;
+            std::array<u8, DIRTY_VRAM_BLOCK_SIZE> data;
+        };
+
+        struct LineState
+        {
+            u8 line;
+            u8 windowLine;  // The window's own line counter
+            u8 lcdc;
+            u8 scrollX;
+            u8 scrollY;
+            u8 windowX;
+            u8 windowY;
+            std::array<u8, 3> palettes; // BGP, OBP0 and OBP1
+
+            // The VRAM blocks written since the line before
+            u32 firstBlock;
+            u32 blockCount;
+
+            bool oamChanged;
+            std::array<u8, OAM_END_ADDR - OAM_START_ADDR> oam; // Only filled in when OAM changed
+
+            bool coloursChanged;
+            Colour::CGBPalette colours; // Only filled in when CGB palette ram changed
+        };
+    public:
+        Renderer(FrameExchange& frames);
+
+        /**
+         * @brief Checks if the window is drawn on a line
+         * 
+         * @param state The line's registers
+         */
+        [[nodiscard]] static auto isWindowVisible(const LineState& state) -> bool;
+
+        /**
+         * @brief Brings the copy of VRAM and OAM up to date, then draws a line
+         * and converts it to pixels, skipping whichever of those already
+         * happened for a line with the same signature
+         * 
+         * @param state The line's registers, and what changed in OAM
+         * 
+         * @param blocks The VRAM blocks written since the line before
+         */
+        void renderLine(const LineState& state, const Block* blocks);
+
+        /**
+         * @brief Converts a line drawn somewhere else, such as by the pixel FIFO,
+         * to pixels. The line's contents are its signature, so it's still only
+         * converted when it has changed
+         * 
+         * @param line The line of the screen
+         * 
+         * @param shades The line's shades, from 0 (lightest) to 3 (darkest)
+         */
+        void presentLine(u8 line, const std::array<u8, SCREEN_WIDTH>& shades);
+
+        /**
+         * @brief Fills the back buffer with the lightest shade, as the screen
+         * looks with the LCD off, and makes sure the next frame is drawn in full
+         * 
+         */
+        void clear();
+
+        /**
+         * @brief Ends the frame being drawn
+         * 
+         * @return Whether any line of it changed from the frame before
+         */
+        auto finishFrame() -> bool;
+
+        /**
+         * @brief Hashes the colour indices of the frame just finished, along with
+         * the palettes each line was drawn with, so the hash doesn't depend on the
+         * colour scheme, but still changes when the palettes do
+         * 
+         */
+        [[nodiscard]] auto getFrameHash() const -> u64;
+
+        /**
+         * @brief Gets the colour indices of the frame just finished
+         * 
+         * @return The indices, a byte per pixel
+         */
+        [[nodiscard]] auto getColourBuffer() const -> const Colour::GBColour*;
+
+        /**
+         * @brief Gets the palettes each line of the frame just finished was drawn with.
+         * DMG lines hold BGP, OBP0 and OBP1 in their low three bytes
+         * 
+         * @return The palettes, one per line
+         */
+        [[nodiscard]] auto getLinePalettes() const -> const std::array<u64, SCREEN_HEIGHT>&;
+
+        /**
+         * @brief Sets the host colours the four shades are drawn with
+         * 
+         * @param shades The colours, from lightest to darkest
+         */
+        void setColourScheme(const Colour::Shades& shades);
+
+        /**
+         * @brief Sets whether lines are drawn in CGB mode
+         * 
+         * @param cgb Whether the game runs in CGB mode
+         */
+        void setCGB(bool cgb);
+    private:
+        /**
+         * @brief Draws a line, and converts it to pixels, once VRAM and OAM are up to date
+         * 
+         * @param state The line's registers
+         * 
+         * @tparam CGB Whether to draw the line in CGB mode
+         */
+        template <bool CGB> void drawLine(const LineState& state);
+
+        /**
+         * @brief Gets a signature of everything a line is drawn from: the registers,
+         * palettes, layer lines and sprites on it. A line with the same signature
+         * as before draws the same pixels
+         * 
+         * @param state The line's registers
+         * @return The signature, which is never INVALID_SIGNATURE
+         * 
+         * @tparam CGB Whether the line is drawn in CGB mode
+         */
+        template <bool CGB> [[nodiscard]] auto getLineSignature(const LineState& state) const -> u64;
+
+        /**
+         * @brief Rebuilds a palette's colours after its register changed
+         * 
+         * @param palette Which palette changed
+         * 
+         * @param value The register's new value
+         */
+        void setPalette(Colour::PaletteID palette, u8 value);
+
+        /**
+         * @brief Draw a background line to the screen
+         * 
+         * @param state The line's registers
+         */
+        void drawBackgroundLine(const LineState& state);
+
+        /**
+         * @brief Draw a window line to the screen
+         * 
+         * @param state The line's registers
+         */
+        void drawWindowLine(const LineState& state);
+
+        /**
+         * @brief Draw the sprites to the screen
+         * 
+         * @param state The line's registers
+         * 
+         * @tparam CGB Whether to draw the sprites in CGB mode
+         */
+        template <bool CGB> void drawSprites(const LineState& state);
+
+        /**
+         * @brief Draw a specified pixel at position (x, y) with
+         * colour c
+         * 
+         * @param x The x coordinate of the pixel
+         * 
+         * @param y The y coordinate of the pixel
+         * 
+         * @param c The colour of the pixel
+         */
+        void drawPixel(u8 x, u8 y, Colour::GBColour);
+
+        /**
+         * @brief Draw a run of pixels along a line, starting at position (x, y).
+         * Only the colour indices are written, the frame buffer is filled once the line is done
+         * 
+         * @param x The x coordinate of the first pixel
+         * 
+         * @param y The y coordinate of the line
+         * 
+         * @param pixels The colours of the pixels
+         * 
+         * @param count The number of pixels to draw
+         */
+        void drawPixels(u8 x, u8 y, const Colour::GBColour* pixels, u8 count);
+
+        /**
+         * @brief Get the colour of a pixel on the screen
+         * 
+         * @param x The x coordinate of the pixel to get
+         * 
+         * @param y The y coordinate of the pixel to get
+         * @return The Gameboy colour at the pixel
+         */
+        [[nodiscard]] auto getPixel(u8 x, u8 y) const -> Colour::GBColour;
+    private:
+        // Marks a line as needing to be drawn no matter what
+        static constexpr u64 INVALID_SIGNATURE = 0;
+
+        // BGP, OBP0 and OBP1 of 0xE4 leave every shade as it is
+        static constexpr u64 IDENTITY_PALETTES = 0xE4E4E4;
+
+        FrameExchange& m_Frames;
+
+        std::array<u8, VRAM_BANK_COUNT * VRAM_BANK_SIZE> m_VRAM;
+        std::array<u8, OAM_END_ADDR - OAM_START_ADDR>   m_OAM;
+        DirtyMap m_DirtyMap;
+
+        TileCache   m_TileCache;
+        LayerCache  m_LayerCache;
+        SpriteLists m_SpriteLists;
+
+        std::array<Colour::GBColour, COLOUR_BUFFER_SIZE> m_ColourBuffer;
+        std::array<u8, 3> m_PaletteRegisters;
+        Colour::Palette m_Palette;
+        Colour::Palette m_ShadePalette; // The shades in order, for lines that come with the palettes already applied
+        Colour::Shades  m_Shades;
+        Colour::CGBPalette m_CGBPalette;
+        bool m_CGB;
+
+        // What each line was last drawn from, and what each line of each frame buffer was converted from
+        std::array<u64, SCREEN_HEIGHT> m_LineSignatures;
+        std::array<std::array<u64, SCREEN_HEIGHT>, FrameExchange::BUFFER_COUNT> m_BufferSignatures;
+        u32  m_PaletteGeneration;
+        bool m_FrameChanged;
+
+        // What the palettes were as each line was drawn, for the frame hash
+        std::array<u64, SCREEN_HEIGHT> m_LinePalettes;
+        u64 m_CGBPaletteHash;
+};
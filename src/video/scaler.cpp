@@ -0,0 +1,499 @@
+#include "core.hpp"
+
+#include "scaler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+/**
+ * @brief Repeats each pixel of some rows a number of times, across and down
+ * 
+ * @param in The first pixel of the first row
+ * 
+ * @param stride The distance between the start of each input row
+ * 
+ * @param width The number of pixels in a row
+ * 
+ * @param rows The number of rows
+ * 
+ * @param out Where to draw the first pixel of the first row, with rows width * factor pixels apart
+ * 
+ * @param factor How many times to repeat each pixel
+ */
+static void repeat(const u32* in, u32 stride, u32 width, u32 rows, u32* out, u8 factor)
+{
+    const u32 outWidth = width * factor;
+
+    for(u32 y = 0; y < rows; ++y, in += stride)
+    {
+        u32 x = 0;
+
+        #ifdef __SSE2__
+        // Spread 4 pixels at a time over 1 to 4 registers with dword shuffles
+        switch(factor)
+        {
+            case 2:
+                for(; x + 4 <= width; x += 4)
+                {
+                    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+                    __m128i* dst   = reinterpret_cast<__m128i*>(out + x * 2);
+                    _mm_storeu_si128(dst,     _mm_unpacklo_epi32(pixels, pixels));
+                    _mm_storeu_si128(dst + 1, _mm_unpackhi_epi32(pixels, pixels));
+                }
+                break;
+            case 3:
+                for(; x + 4 <= width; x += 4)
+                {
+                    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+                    __m128i* dst   = reinterpret_cast<__m128i*>(out + x * 3);
+                    _mm_storeu_si128(dst,     _mm_shuffle_epi32(pixels, _MM_SHUFFLE(1, 0, 0, 0)));
+                    _mm_storeu_si128(dst + 1, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(2, 2, 1, 1)));
+                    _mm_storeu_si128(dst + 2, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(3, 3, 3, 2)));
+                }
+                break;
+            case 4:
+                for(; x + 4 <= width; x += 4)
+                {
+                    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+                    __m128i* dst   = reinterpret_cast<__m128i*>(out + x * 4);
+                    _mm_storeu_si128(dst,     _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 0, 0, 0)));
+                    _mm_storeu_si128(dst + 1, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(1, 1, 1, 1)));
+                    _mm_storeu_si128(dst + 2, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(2, 2, 2, 2)));
+                    _mm_storeu_si128(dst + 3, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(3, 3, 3, 3)));
+                }
+                break;
+        }
+        #endif
+
+        for(; x < width; ++x)
+        {
+            std::fill_n(out + x * factor, factor, in[x]);
+        }
+
+        // Then the rest of the rows are copies of the first
+        for(u8 copy = 1; copy < factor; ++copy)
+        {
+            std::memcpy(out + copy * outWidth, out, outWidth * sizeof(u32));
+        }
+
+        out += outWidth * factor;
+    }
+}
+
+#ifdef __SSE2__
+static __always_inline auto select(__m128i mask, __m128i a, __m128i b) -> __m128i
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+/**
+ * @brief Doubles the size of some rows with Scale2x, which turns each pixel into 4,
+ * taking the colour of a neighbour for the corners where two neighbours agree
+ * 
+ * @param in The first pixel of the first row, with a border of at least 1 pixel around the rows
+ * 
+ * @param stride The distance between the start of each input row
+ * 
+ * @param width The number of pixels in a row
+ * 
+ * @param rows The number of rows
+ * 
+ * @param out Where to draw the first pixel of the first row, with rows width * 2 pixels apart
+ */
+static void scale2x(const u32* in, u32 stride, u32 width, u32 rows, u32* out)
+{
+    // Around each pixel E:  . B .
+    //                       D E F
+    //                       . H .
+    const u32 outWidth = width * 2;
+
+    for(u32 y = 0; y < rows; ++y, in += stride, out += outWidth * 2)
+    {
+        const u32* up   = in - stride;
+        const u32* down = in + stride;
+        u32* top    = out;
+        u32* bottom = out + outWidth;
+
+        u32 x = 0;
+
+        #ifdef __SSE2__
+        for(; x + 4 <= width; x += 4)
+        {
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + x));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x - 1));
+            __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+            __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x + 1));
+            __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(down + x));
+
+            __m128i db = _mm_cmpeq_epi32(d, b);
+            __m128i bf = _mm_cmpeq_epi32(b, f);
+            __m128i dh = _mm_cmpeq_epi32(d, h);
+            __m128i fh = _mm_cmpeq_epi32(f, h);
+
+            __m128i e0 = select(_mm_andnot_si128(_mm_or_si128(bf, dh), db), d, e);
+            __m128i e1 = select(_mm_andnot_si128(_mm_or_si128(db, fh), bf), f, e);
+            __m128i e2 = select(_mm_andnot_si128(_mm_or_si128(db, fh), dh), d, e);
+            __m128i e3 = select(_mm_andnot_si128(_mm_or_si128(dh, bf), fh), f, e);
+
+            // Interleave the left and right halves of each output pixel
+            __m128i* dst = reinterpret_cast<__m128i*>(top + x * 2);
+            _mm_storeu_si128(dst,     _mm_unpacklo_epi32(e0, e1));
+            _mm_storeu_si128(dst + 1, _mm_unpackhi_epi32(e0, e1));
+
+            dst = reinterpret_cast<__m128i*>(bottom + x * 2);
+            _mm_storeu_si128(dst,     _mm_unpacklo_epi32(e2, e3));
+            _mm_storeu_si128(dst + 1, _mm_unpackhi_epi32(e2, e3));
+        }
+        #endif
+
+        for(; x < width; ++x)
+        {
+            u32 b = up[x], d = *(in + x - 1), e = in[x], f = in[x + 1], h = down[x];
+
+            top[x * 2]        = (d == b && b != f && d != h) ? d : e;
+            top[x * 2 + 1]    = (b == f && b != d && f != h) ? f : e;
+            bottom[x * 2]     = (d == h && d != b && h != f) ? d : e;
+            bottom[x * 2 + 1] = (h == f && d != h && b != f) ? f : e;
+        }
+    }
+}
+
+/**
+ * @brief Triples the size of some rows with Scale3x, which turns each pixel into 9,
+ * the same way Scale2x does, with the edge pixels between the corners also following their neighbours
+ * 
+ * @param in The first pixel of the first row, with a border of at least 1 pixel around the rows
+ * 
+ * @param stride The distance between the start of each input row
+ * 
+ * @param width The number of pixels in a row
+ * 
+ * @param rows The number of rows
+ * 
+ * @param out Where to draw the first pixel of the first row, with rows width * 3 pixels apart
+ */
+static void scale3x(const u32* in, u32 stride, u32 width, u32 rows, u32* out)
+{
+    // Around each pixel E:  A B C
+    //                       D E F
+    //                       G H I
+    const u32 outWidth = width * 3;
+
+    for(u32 y = 0; y < rows; ++y, in += stride, out += outWidth * 3)
+    {
+        const u32* up   = in - stride;
+        const u32* down = in + stride;
+
+        for(u32 x = 0; x < width; ++x)
+        {
+            u32 a = *(up + x - 1),   b = up[x],   c = up[x + 1];
+            u32 d = *(in + x - 1),   e = in[x],   f = in[x + 1];
+            u32 g = *(down + x - 1), h = down[x], i = down[x + 1];
+
+            u32* top    = out + x * 3;
+            u32* middle = top + outWidth;
+            u32* bottom = middle + outWidth;
+
+            if(b == h || d == f)
+            {
+                std::fill_n(top, 3, e);
+                std::fill_n(middle, 3, e);
+                std::fill_n(bottom, 3, e);
+                continue;
+            }
+
+            top[0]    = d == b ? d : e;
+            top[1]    = (d == b && e != c) || (b == f && e != a) ? b : e;
+            top[2]    = b == f ? f : e;
+            middle[0] = (d == b && e != g) || (d == h && e != a) ? d : e;
+            middle[1] = e;
+            middle[2] = (b == f && e != i) || (h == f && e != c) ? f : e;
+            bottom[0] = d == h ? d : e;
+            bottom[1] = (d == h && e != i) || (h == f && e != g) ? h : e;
+            bottom[2] = h == f ? f : e;
+        }
+    }
+}
+
+static __always_inline auto distance(const Scaler::YUV& a, const Scaler::YUV& b) -> u32
+{
+    // Differences in brightness stand out far more than differences in colour
+    return 48 * std::abs(a.y - b.y) + 7 * std::abs(a.u - b.u) + 6 * std::abs(a.v - b.v);
+}
+
+static __always_inline auto blend(u32 a, u32 b) -> u32
+{
+    // Average each channel, without letting the halves carry into the next one
+    return (a & b) + (((a ^ b) & 0xFEFEFEFE) >> 1);
+}
+
+/**
+ * @brief Works out one corner of a pixel for xBR. The corner is smoothed when there's
+ * less of an edge running along the diagonal through it than across that diagonal
+ * 
+ * @param in The pixel, with a border of at least 2 pixels around it
+ * 
+ * @param yuv The pixel's brightness and colour, laid out the same as in
+ * 
+ * @param stride The distance between the start of each row
+ * 
+ * @tparam SX The direction of the corner across, 1 for right or -1 for left
+ * 
+ * @tparam SY The direction of the corner down, 1 for down or -1 for up
+ * @return The corner's colour
+ */
+template <int SX, int SY>
+static __always_inline auto xbrCorner(const u32* in, const Scaler::YUV* yuv, i32 stride) -> u32
+{
+    // Around the pixel E, facing the corner:  . B . .
+    //                                         D E F F4
+    //                                         . H I I4
+    //                                         . H5 I5
+    auto at = [&](i32 x, i32 y) -> const Scaler::YUV& { return yuv[SX * x + SY * y * stride]; };
+
+    const Scaler::YUV& e = at(0, 0);
+    const Scaler::YUV& f = at(1, 0);
+    const Scaler::YUV& h = at(0, 1);
+    const Scaler::YUV& i = at(1, 1);
+
+    // How much of an edge there is along the diagonal through the corner, and across it
+    u32 along  = distance(e, at(1, -1)) + distance(e, at(-1, 1)) + distance(i, at(2, 0)) + distance(i, at(0, 2)) + 4 * distance(h, f);
+    u32 across = distance(h, at(-1, 0)) + distance(h, at(1, 2)) + distance(f, at(2, 1)) + distance(f, at(0, -1)) + 4 * distance(e, i);
+
+    u32 pixel = in[0];
+    if(along < across)
+    {
+        // Blend towards whichever side of the edge looks more like the pixel
+        u32 side = distance(e, f) <= distance(e, h) ? in[SX] : in[SY * stride];
+        pixel = blend(pixel, side);
+    }
+
+    return pixel;
+}
+
+/**
+ * @brief Doubles the size of some rows with xBR, which finds edges at any angle by
+ * comparing how different pixels look, and blends the corners that sit on them
+ * 
+ * @param in The first pixel of the first row, with a border of at least 2 pixels around the rows
+ * 
+ * @param yuv The brightness and colour of each pixel, laid out the same as in
+ * 
+ * @param stride The distance between the start of each input row
+ * 
+ * @param width The number of pixels in a row
+ * 
+ * @param rows The number of rows
+ * 
+ * @param out Where to draw the first pixel of the first row, with rows width * 2 pixels apart
+ */
+static void xbr(const u32* in, const Scaler::YUV* yuv, u32 stride, u32 width, u32 rows, u32* out)
+{
+    const u32 outWidth = width * 2;
+
+    for(u32 y = 0; y < rows; ++y, in += stride, yuv += stride, out += outWidth * 2)
+    {
+        u32* top    = out;
+        u32* bottom = out + outWidth;
+
+        for(u32 x = 0; x < width; ++x)
+        {
+            top[x * 2]        = xbrCorner<-1, -1>(in + x, yuv + x, stride);
+            top[x * 2 + 1]    = xbrCorner< 1, -1>(in + x, yuv + x, stride);
+            bottom[x * 2]     = xbrCorner<-1,  1>(in + x, yuv + x, stride);
+            bottom[x * 2 + 1] = xbrCorner< 1,  1>(in + x, yuv + x, stride);
+        }
+    }
+}
+
+static auto toYUV(u32 pixel) -> Scaler::YUV
+{
+    i32 red   = pixel & 0xFF;
+    i32 green = (pixel >> 8) & 0xFF;
+    i32 blue  = (pixel >> 16) & 0xFF;
+
+    i32 y = (red * 77 + green * 150 + blue * 29) >> 8;
+    return { static_cast<i16>(y), static_cast<i16>(blue - y), static_cast<i16>(red - y) };
+}
+
+Scaler::Scaler()
+    : m_Filter(ScaleFilter::Nearest), m_Scale(1), m_FilterScale(1), m_RepeatScale(1), m_Padded({}), m_YUV({}),
+      m_Submitted(0), m_Completed(0), m_Stopping(false), m_Scaled(nullptr)
+{
+    // With a core to spare, half of each frame is scaled alongside the caller
+    if(std::thread::hardware_concurrency() > 1)
+    {
+        m_Thread = std::thread(&Scaler::scaleLoop, this);
+    }
+}
+
+Scaler::~Scaler()
+{
+    if(m_Thread.joinable())
+    {
+        m_Stopping.store(true, std::memory_order_relaxed);
+        m_Submitted.fetch_add(1, std::memory_order_release);
+        m_Submitted.notify_one();
+        m_Thread.join();
+    }
+}
+
+auto Scaler::getFilterScale(ScaleFilter filter) -> u8
+{
+    switch(filter)
+    {
+        case ScaleFilter::Scale2x:
+        case ScaleFilter::XBR:
+            return 2;
+        case ScaleFilter::Scale3x:
+            return 3;
+        default:
+            return 1;
+    }
+}
+
+void Scaler::setFilter(ScaleFilter filter, u8 scale)
+{
+    m_Scale = std::max<u8>(scale, 1);
+
+    // Filters that don't divide the scale are left out, and the frame is just repeated
+    u8 filterScale = getFilterScale(filter);
+    if(m_Scale % filterScale != 0)
+    {
+        filter      = ScaleFilter::Nearest;
+        filterScale = 1;
+    }
+
+    m_Filter      = filter;
+    m_FilterScale = filterScale;
+    m_RepeatScale = m_Scale / filterScale;
+
+    if(m_FilterScale > 1 && m_RepeatScale > 1)
+    {
+        m_Filtered.resize(COLOUR_BUFFER_SIZE * m_FilterScale * m_FilterScale);
+    }
+    else
+    {
+        m_Filtered.clear();
+    }
+}
+
+auto Scaler::getFilter() const -> ScaleFilter
+{
+    return m_Filter;
+}
+
+auto Scaler::getScale() const -> u8
+{
+    return m_Scale;
+}
+
+void Scaler::scale(const u8* frame, u32* scaled)
+{
+    pad(frame);
+
+    if(!m_Thread.joinable())
+    {
+        scaleRows(0, SCREEN_HEIGHT, scaled);
+        return;
+    }
+
+    // Hand the bottom half to the worker, and scale the top half in the meantime.
+    // Release so the worker sees the padded frame before it sees the count
+    m_Scaled = scaled;
+    u32 submitted = m_Submitted.fetch_add(1, std::memory_order_release) + 1;
+    m_Submitted.notify_one();
+
+    scaleRows(0, SCREEN_HEIGHT / 2, scaled);
+
+    for(u32 completed = m_Completed.load(std::memory_order_acquire); completed != submitted; completed = m_Completed.load(std::memory_order_acquire))
+    {
+        m_Completed.wait(completed, std::memory_order_acquire);
+    }
+}
+
+void Scaler::pad(const u8* frame)
+{
+    u32* start = &m_Padded[PADDING * PADDED_WIDTH + PADDING];
+
+    for(u32 y = 0; y < SCREEN_HEIGHT; ++y)
+    {
+        u32* row = start + y * PADDED_WIDTH;
+        std::memcpy(row, frame + y * SCREEN_WIDTH * 4, SCREEN_WIDTH * sizeof(u32));
+
+        std::fill_n(row - PADDING, PADDING, row[0]);
+        std::fill_n(row + SCREEN_WIDTH, PADDING, row[SCREEN_WIDTH - 1]);
+    }
+
+    // The top and bottom borders are copies of the first and last rows, border included
+    for(u32 y = 0; y < PADDING; ++y)
+    {
+        std::memcpy(&m_Padded[y * PADDED_WIDTH], start - PADDING, PADDED_WIDTH * sizeof(u32));
+        std::memcpy(&m_Padded[(PADDED_HEIGHT - 1 - y) * PADDED_WIDTH], start - PADDING + (SCREEN_HEIGHT - 1) * PADDED_WIDTH, PADDED_WIDTH * sizeof(u32));
+    }
+
+    if(m_Filter == ScaleFilter::XBR)
+    {
+        std::transform(m_Padded.begin(), m_Padded.end(), m_YUV.begin(), toYUV);
+    }
+}
+
+void Scaler::scaleRows(u32 first, u32 last, u32* scaled)
+{
+    const u32* in  = &m_Padded[(PADDING + first) * PADDED_WIDTH + PADDING];
+    const u32 rows = last - first;
+
+    // When the filter's output still has to be repeated, it goes through its own buffer first
+    const u32 filteredWidth = SCREEN_WIDTH * m_FilterScale;
+    u32* filtered = m_RepeatScale > 1 ? m_Filtered.data() + first * m_FilterScale * filteredWidth
+                                      : scaled + first * m_Scale * SCREEN_WIDTH * m_Scale;
+
+    switch(m_Filter)
+    {
+        case ScaleFilter::Scale2x:
+            scale2x(in, PADDED_WIDTH, SCREEN_WIDTH, rows, filtered);
+            break;
+        case ScaleFilter::Scale3x:
+            scale3x(in, PADDED_WIDTH, SCREEN_WIDTH, rows, filtered);
+            break;
+        case ScaleFilter::XBR:
+            xbr(in, &m_YUV[(PADDING + first) * PADDED_WIDTH + PADDING], PADDED_WIDTH, SCREEN_WIDTH, rows, filtered);
+            break;
+        default:
+            repeat(in, PADDED_WIDTH, SCREEN_WIDTH, rows, scaled + first * m_Scale * SCREEN_WIDTH * m_Scale, m_Scale);
+            return;
+    }
+
+    if(m_RepeatScale > 1)
+    {
+        repeat(filtered, filteredWidth, filteredWidth, rows * m_FilterScale, scaled + first * m_Scale * SCREEN_WIDTH * m_Scale, m_RepeatScale);
+    }
+}
+
+void Scaler::scaleLoop()
+{
+    u32 completed = 0;
+
+    while(true)
+    {
+        // Sleep until there's a frame to scale
+        m_Submitted.wait(completed, std::memory_order_acquire);
+
+        if(m_Stopping.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        scaleRows(SCREEN_HEIGHT / 2, SCREEN_HEIGHT, m_Scaled);
+
+        // Release so the caller sees the rows drawn before it sees the count
+        m_Completed.store(++completed, std::memory_order_release);
+        m_Completed.notify_one();
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "video_defs.hpp"
+
+/**
+    Scales finished frames up on the CPU, for renderers that are slow
+    to stretch a texture themselves, and for the pixel art filters.
+
+    Each filter has its own scale (2 or 3, or 1 for nearest neighbour),
+    and whatever is left of the rendering scale after it is made up by
+    repeating pixels, so Scale2x at a scale of 4 is Scale2x followed
+    by doubling. A filter that doesn't divide the scale falls back to
+    nearest neighbour.
+
+    Frames are copied into a buffer with a border of repeated edge
+    pixels first, so the filters never have to check the edges. With
+    a core to spare, the bottom half of the frame is scaled on a worker
+    thread while the caller scales the top half.
+**/
+
+class Scaler
+{
+    public:
+        // A pixel's brightness and colour, to measure how different two pixels look
+        struct YUV
+        {
+            i16 y;
+            i16 u;
+            i16 v;
+        };
+    public:
+        Scaler();
+        ~Scaler();
+
+        /**
+         * @brief Gets the scale a filter draws at by itself
+         * 
+         * @param filter The filter
+         */
+        [[nodiscard]] static auto getFilterScale(ScaleFilter filter) -> u8;
+
+        /**
+         * @brief Sets the filter, and the scale of the frames it draws
+         * 
+         * @param filter The filter to draw with
+         * 
+         * @param scale The size of the frames drawn, as a multiple of the screen
+         */
+        void setFilter(ScaleFilter filter, u8 scale);
+
+        /**
+         * @brief Gets the filter frames are drawn with
+         * 
+         */
+        [[nodiscard]] auto getFilter() const -> ScaleFilter;
+
+        /**
+         * @brief Gets the size of the frames drawn, as a multiple of the screen
+         * 
+         */
+        [[nodiscard]] auto getScale() const -> u8;
+
+        /**
+         * @brief Scales a frame up
+         * 
+         * @param frame The frame, as RGBA pixels
+         * 
+         * @param scaled The buffer to draw the scaled frame into, which must hold
+         * (SCREEN_WIDTH * scale) * (SCREEN_HEIGHT * scale) pixels
+         */
+        void scale(const u8* frame, u32* scaled);
+    private:
+        // The filters look up to 2 pixels away
+        static constexpr u32 PADDING        = 2;
+        static constexpr u32 PADDED_WIDTH   = SCREEN_WIDTH + 2 * PADDING;
+        static constexpr u32 PADDED_HEIGHT  = SCREEN_HEIGHT + 2 * PADDING;
+
+        /**
+         * @brief Copies a frame into the padded buffer, repeating the edge pixels into the border
+         * 
+         * @param frame The frame, as RGBA pixels
+         */
+        void pad(const u8* frame);
+
+        /**
+         * @brief Scales a range of the frame's rows, once it has been padded
+         * 
+         * @param first The first row of the screen to scale
+         * 
+         * @param last One past the last row to scale
+         * 
+         * @param scaled The buffer to draw the scaled frame into
+         */
+        void scaleRows(u32 first, u32 last, u32* scaled);
+
+        /**
+         * @brief Scales the bottom half of each frame handed over
+         * 
+         */
+        void scaleLoop();
+    private:
+        ScaleFilter m_Filter;
+        u8 m_Scale;
+        u8 m_FilterScale;   // What the filter draws at
+        u8 m_RepeatScale;   // What's left to make up by repeating pixels
+
+        std::array<u32, PADDED_WIDTH * PADDED_HEIGHT> m_Padded;
+        std::array<YUV, PADDED_WIDTH * PADDED_HEIGHT> m_YUV;
+        std::vector<u32> m_Filtered; // The filter's output, when it still has to be repeated
+
+        // Frames are counted as they're handed over and finished, so each side can wait on the other
+        std::thread m_Thread;
+        std::atomic<u32> m_Submitted;
+        std::atomic<u32> m_Completed;
+        std::atomic<bool> m_Stopping;
+        u32* m_Scaled;
+};
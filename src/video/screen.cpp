@@ -20,7 +20,7 @@ void Screen::quitSDL()
 }
 
 Screen::Screen()
-    : m_RenderingScale(DEFAULT_RENDERING_SCALE)
+    : m_Texture(nullptr), m_RenderingScale(DEFAULT_RENDERING_SCALE), m_ScaleFilter(ScaleFilter::None)
 {
     DEBUG("Initializing Screen.");
     
@@ -41,7 +41,7 @@ Screen::Screen()
     }
     DEBUG("\tRenderer Created.");
 
-    m_Texture = SDL_CreateTexture(m_Renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
+    createTexture();
 }
 
 Screen::~Screen()
@@ -53,7 +53,16 @@ Screen::~Screen()
 
 void Screen::draw(const std::array<u8, FRAME_BUFFER_SIZE>& buffer)
 {
-    SDL_UpdateTexture(m_Texture, nullptr, buffer.data(), SCREEN_WIDTH * 4);
+    if(m_ScaleFilter == ScaleFilter::None)
+    {
+        SDL_UpdateTexture(m_Texture, nullptr, buffer.data(), SCREEN_WIDTH * 4);
+    }
+    else
+    {
+        m_Scaler.scale(buffer.data(), m_Scaled.data());
+        SDL_UpdateTexture(m_Texture, nullptr, m_Scaled.data(), SCREEN_WIDTH * m_Scaler.getScale() * 4);
+    }
+
     SDL_RenderCopy(m_Renderer, m_Texture, nullptr, nullptr);
     SDL_RenderPresent(m_Renderer);
 }
@@ -69,12 +78,12 @@ auto Screen::getTitle() const -> const std::string&
     return m_Title;
 }
 
-void Screen::setTitleFPS(u32 fps)
+void Screen::setTitleFPS(float fps)
 {
     std::stringstream ss;
     ss << m_Title
-       << ", " << std::setprecision(4) << (static_cast<float>(fps) * TARGET_SPEED_MULTIPLIER)
-       << "% (" << fps << " FPS)";
+       << ", " << std::setprecision(4) << (fps * TARGET_SPEED_MULTIPLIER)
+       << "% (" << std::setprecision(3) << fps << " FPS)";
     SDL_SetWindowTitle(m_Window, ss.str().c_str());
 }
 
@@ -84,9 +93,41 @@ void Screen::setRenderingScale(u8 renderingScale)
 
     SDL_SetWindowSize(m_Window, SCREEN_WIDTH * m_RenderingScale, SCREEN_HEIGHT * m_RenderingScale);
     DEBUG("Resized the window to " << (SCREEN_WIDTH * m_RenderingScale) << "x" << (SCREEN_HEIGHT * m_RenderingScale) << ".");
+
+    createTexture();
 }
 
 auto Screen::getRenderingScale() const -> u32
 {
     return m_RenderingScale;
 }
+
+void Screen::setScaleFilter(ScaleFilter filter)
+{
+    m_ScaleFilter = filter;
+    createTexture();
+}
+
+void Screen::createTexture()
+{
+    if(m_Texture)
+    {
+        SDL_DestroyTexture(m_Texture);
+    }
+
+    // Frames scaled on the CPU are uploaded at the size of the window, so SDL only has to copy them
+    u32 scale = 1;
+    if(m_ScaleFilter != ScaleFilter::None)
+    {
+        m_Scaler.setFilter(m_ScaleFilter, m_RenderingScale);
+        scale = m_Scaler.getScale();
+        m_Scaled.resize(COLOUR_BUFFER_SIZE * scale * scale);
+    }
+    else
+    {
+        m_Scaled.clear();
+        m_Scaled.shrink_to_fit();
+    }
+
+    m_Texture = SDL_CreateTexture(m_Renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH * scale, SCREEN_HEIGHT * scale);
+}
@@ -3,9 +3,12 @@
 #include "core.hpp"
 
 #include <array>
+#include <vector>
 
 #include <SDL2/SDL.h>
 
+#include "scaler.hpp"
+
 class Gameboy;
 
 class Screen
@@ -51,7 +54,7 @@ class Screen
          * 
          * @param fps The fps to set
          */
-        void setTitleFPS(u32 fps);
+        void setTitleFPS(float fps);
 
         /**
          * @brief Set the rendering scale of the window
@@ -65,6 +68,21 @@ class Screen
          * 
          */
         auto getRenderingScale() const -> u32;
+
+        /**
+         * @brief Set the filter frames are scaled up with. With ScaleFilter::None
+         * the frame is left for SDL to stretch, otherwise it's scaled on the CPU
+         * to the rendering scale before it's uploaded
+         * 
+         * @param filter The filter to scale with
+         */
+        void setScaleFilter(ScaleFilter filter);
+    private:
+        /**
+         * @brief Creates the texture frames are uploaded to, at the size they're uploaded at
+         * 
+         */
+        void createTexture();
     private:
         SDL_Window*     m_Window;
         SDL_Renderer*   m_Renderer;
@@ -72,4 +90,8 @@ class Screen
 
         std::string m_Title;
         u32 m_RenderingScale;
+
+        ScaleFilter m_ScaleFilter;
+        Scaler m_Scaler;
+        std::vector<u32> m_Scaled;
 };
@@ -0,0 +1,57 @@
+#include "core.hpp"
+
+#include "sprite_lists.hpp"
+
+#include <algorithm>
+
+#include "dirty_map.hpp"
+
+SpriteLists::SpriteLists()
+    : m_Lines({}), m_Generation(0), m_SpriteHeight(0), m_SortByX(true) {}
+
+void SpriteLists::update(const u8* oam, const DirtyMap& dirtyMap, u8 spriteHeight, bool sortByX)
+{
+    if(spriteHeight == m_SpriteHeight && sortByX == m_SortByX && !dirtyMap.isPageDirty(OAM_START_ADDR, m_Generation))
+    {
+        return;
+    }
+
+    for(Line& line : m_Lines)
+    {
+        line.count = 0;
+    }
+
+    // Scan OAM in order, so the first 10 sprites on a line are the ones that get kept
+    for(u8 sprite = 0; sprite < SPRITE_COUNT; ++sprite)
+    {
+        int spriteYPos = oam[sprite * BYTES_PER_SPRITE] - SPRITE_Y_OFFSET;
+
+        int first = std::max(spriteYPos, 0);
+        int last  = std::min(spriteYPos + spriteHeight, static_cast<int>(SCREEN_HEIGHT));
+
+        for(int y = first; y < last; ++y)
+        {
+            Line& line = m_Lines[y];
+            if(line.count < SPRITES_PER_LINE)
+            {
+                line.sprites[line.count++] = sprite;
+            }
+        }
+    }
+
+    // The sprite furthest left is drawn on top, and a stable sort leaves ties in OAM order
+    if(sortByX)
+    {
+        for(Line& line : m_Lines)
+        {
+            std::stable_sort(line.sprites.begin(), line.sprites.begin() + line.count, [oam](u8 a, u8 b)
+            {
+                return oam[a * BYTES_PER_SPRITE + 1] < oam[b * BYTES_PER_SPRITE + 1];
+            });
+        }
+    }
+
+    m_Generation   = dirtyMap.getGeneration();
+    m_SpriteHeight = spriteHeight;
+    m_SortByX      = sortByX;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+
+class DirtyMap;
+
+/**
+    The sprites on each line of the screen, as the OAM scan would find
+    them: at most 10 per line, taken in OAM order, and then sorted into
+    drawing priority, where the sprite further left wins and ties go to
+    the one earlier in OAM. In CGB mode the sprite earlier in OAM always
+    wins, so the lists are left in OAM order.
+
+    The lists are only rebuilt when OAM has been written to (by the CPU
+    or DMA), or the sprite height has changed.
+**/
+
+class SpriteLists
+{
+    public:
+        struct Line
+        {
+            u8 count;
+            std::array<u8, SPRITES_PER_LINE> sprites; // OAM indices, highest priority first
+        };
+    public:
+        SpriteLists();
+
+        /**
+         * @brief Rebuilds the lists if OAM or the sprite height changed since the last update
+         * 
+         * @param oam A pointer to the start of OAM
+         * 
+         * @param dirtyMap The dirty map tracking OAM writes, already synced
+         * 
+         * @param spriteHeight The height of sprites, 8 or 16
+         * 
+         * @param sortByX Whether sprites further left win (DMG), rather than just those earlier in OAM (CGB)
+         */
+        void update(const u8* oam, const DirtyMap& dirtyMap, u8 spriteHeight, bool sortByX = true);
+
+        /**
+         * @brief Gets the sprites on a line
+         * 
+         * @param line The line of the screen
+         */
+        [[nodiscard]] __always_inline auto getLine(u8 line) const -> const Line&;
+    private:
+        std::array<Line, SCREEN_HEIGHT> m_Lines;
+
+        u64  m_Generation;
+        u8   m_SpriteHeight;
+        bool m_SortByX;
+};
+
+//--------------------------  Inline function implementations --------------------------//
+
+__always_inline auto SpriteLists::getLine(u8 line) const -> const Line&
+{
+    return m_Lines[line];
+}
@@ -0,0 +1,46 @@
+#include "core.hpp"
+
+#include "tile_cache.hpp"
+
+#include <cstring>
+
+#include "dirty_map.hpp"
+
+TileCache::TileCache()
+    : m_Tiles({}), m_FlippedTiles({}), m_TileGenerations({}), m_Generation(0)
+{
+    // VRAM starts zeroed, and so do the decoded tiles
+}
+
+void TileCache::update(const u8* vram, const DirtyMap& dirtyMap)
+{
+    if(dirtyMap.getVRAMGeneration() <= m_Generation)
+    {
+        return;
+    }
+
+    dirtyMap.forEachDirtyVRAM(m_Generation, [&](u16 address)
+    {
+        u16 bank = (address - VRAM_START_ADDR) / VRAM_BANK_SIZE;
+        u16 tile = (address - VRAM_START_ADDR) % VRAM_BANK_SIZE / BYTES_PER_TILE;
+        if(tile < TILE_COUNT) // The rest of the bank is the tile maps (or their attributes)
+        {
+            decode(vram + (address - VRAM_START_ADDR), bank * TILE_COUNT + tile);
+            m_TileGenerations[bank * TILE_COUNT + tile] = dirtyMap.getGeneration();
+        }
+    });
+
+    m_Generation = dirtyMap.getGeneration();
+}
+
+void TileCache::decode(const u8* data, u16 tile)
+{
+    for(u8 row = 0; row < TILE_HEIGHT; ++row)
+    {
+        u64 pixels  = Tile::decodeRow(data + 2 * row);
+        u64 flipped = Tile::decodeRow(data + 2 * row, true);
+
+        std::memcpy(&m_Tiles       [tile][row * TILE_WIDTH], &pixels,  TILE_WIDTH);
+        std::memcpy(&m_FlippedTiles[tile][row * TILE_WIDTH], &flipped, TILE_WIDTH);
+    }
+}
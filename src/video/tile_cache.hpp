@@ -0,0 +1,85 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <array>
+
+#include "video_defs.hpp"
+
+class DirtyMap;
+
+/**
+    Keeps every tile in VRAM decoded into one colour index per pixel,
+    along with a horizontally mirrored copy for sprites. A tile is only
+    decoded again once its 16 bytes have been written to, which the
+    DirtyMap tracks for us, as each VRAM block is exactly one tile.
+
+    The tiles in the CGB's second VRAM bank follow on from the first
+    bank's, as tiles 384-767.
+**/
+
+class TileCache
+{
+    public:
+        TileCache();
+
+        /**
+         * @brief Decodes any tiles written to since the last update
+         * 
+         * @param vram A pointer to the start of VRAM
+         * 
+         * @param dirtyMap The dirty map tracking VRAM writes, already synced
+         */
+        void update(const u8* vram, const DirtyMap& dirtyMap);
+
+        /**
+         * @brief Gets a decoded row of a tile
+         * 
+         * @param tile The tile's index from the start of VRAM (0-383, or 384-767 in bank 1)
+         * 
+         * @param row The row within the tile
+         * 
+         * @param flip Whether to get the horizontally mirrored row
+         * @return A pointer to the row's 8 colour indices
+         */
+        [[nodiscard]] __always_inline auto getRow(u16 tile, u8 row, bool flip = false) const -> const Colour::GBColour*;
+
+        /**
+         * @brief Gets the generation a tile was last decoded in, so
+         * anything drawn from it can tell when it has changed
+         * 
+         * @param tile The tile's index from the start of VRAM (0-383, or 384-767 in bank 1)
+         */
+        [[nodiscard]] __always_inline auto getGeneration(u16 tile) const -> u64;
+    private:
+        using DecodedTile = std::array<Colour::GBColour, TILE_WIDTH * TILE_HEIGHT>;
+
+        static constexpr u16 TILES = VRAM_BANK_COUNT * TILE_COUNT;
+
+        /**
+         * @brief Decodes a single tile
+         * 
+         * @param data The tile's 16 bytes
+         * 
+         * @param tile The tile's index
+         */
+        void decode(const u8* data, u16 tile);
+    private:
+        std::array<DecodedTile, TILES> m_Tiles;
+        std::array<DecodedTile, TILES> m_FlippedTiles;
+        std::array<u64, TILES>         m_TileGenerations;
+
+        u64 m_Generation;
+};
+
+//--------------------------  Inline function implementations --------------------------//
+
+__always_inline auto TileCache::getRow(u16 tile, u8 row, bool flip) const -> const Colour::GBColour*
+{
+    return &(flip ? m_FlippedTiles : m_Tiles)[tile][row * TILE_WIDTH];
+}
+
+__always_inline auto TileCache::getGeneration(u16 tile) const -> u64
+{
+    return m_TileGenerations[tile];
+}
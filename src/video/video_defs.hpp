@@ -2,6 +2,9 @@
 
 #include "core.hpp"
 
+#include <array>
+#include <climits>
+
 // TODO: Maybe move colour to its own file?
 
 enum class VideoMode
@@ -12,9 +15,52 @@ enum class VideoMode
     Transfer    // Mode 3
 };
 
+/**
+ * @brief The LCD registers the PPU owns. LY and the mode and
+ * coincidence bits of STAT aren't stored, they're worked out
+ * from where the PPU is whenever they're read
+ */
+struct VideoRegisters
+{
+    u8 lcdc;
+    u8 stat;    // Only the interrupt selects
+    u8 scrollY;
+    u8 scrollX;
+    u8 lyc;
+    u8 bgp;
+    u8 obp0;
+    u8 obp1;
+    u8 windowY;
+    u8 windowX;
+    u8 bgPaletteIndex;  // CGB only
+    u8 objPaletteIndex; // CGB only
+};
+
+enum class RenderMode
+{
+    Scanline,   // Draw each line in one go, with mode 3 always the same length
+    PixelFIFO   // Push pixels out a dot at a time, with mode 3 as long as it takes
+};
+
+enum class RenderSkip
+{
+    Never,      // Render every frame
+    Interval,   // Render one frame in every N
+    OnDemand    // Only render frames that have been asked for
+};
+
+enum class ScaleFilter
+{
+    None,       // Leave scaling to SDL
+    Nearest,    // Repeat each pixel, on the CPU
+    Scale2x,    // Round off diagonal edges, doubling the size
+    Scale3x,    // Round off diagonal edges, tripling the size
+    XBR         // Smooth edges of any angle, blending along them, doubling the size
+};
+
 namespace Colour
 {
-    enum GBColour
+    enum GBColour : u8
     {
         WHITE       = 0b00,
         LIGHT_GRAY  = 0b01,
@@ -29,6 +75,156 @@ namespace Colour
         u8 blue;
         u8 alpha;
     };
+
+    /**
+     * @brief The host colour of each of the four shades, from lightest to darkest
+     */
+    using Shades = std::array<ScreenColour, 4>;
+
+    constexpr Shades GREEN_SHADES = {{
+        { 0x9B, 0xBC, 0x0F, 0xFF },
+        { 0x8B, 0xAC, 0x0F, 0xFF },
+        { 0x30, 0x62, 0x30, 0xFF },
+        { 0x0F, 0x38, 0x0F, 0xFF }
+    }};
+
+    constexpr Shades GREY_SHADES = {{
+        { 0xFF, 0xFF, 0xFF, 0xFF },
+        { 0xAA, 0xAA, 0xAA, 0xFF },
+        { 0x55, 0x55, 0x55, 0xFF },
+        { 0x00, 0x00, 0x00, 0xFF }
+    }};
+
+    /**
+     * @brief Which palette register a pixel's colour index goes through.
+     * Pixels carry it above their colour index, so a whole line can be
+     * converted to RGBA through one table
+     */
+    enum class PaletteID : u8
+    {
+        Background  = 0,
+        Object0     = 1,
+        Object1     = 2
+    };
+
+    constexpr u8 PALETTE_SHIFT  = 2;
+    constexpr u8 COLOUR_MASK    = 0b11;
+
+    // In CGB mode the 8 object palettes come after the 8 background palettes, so tagged
+    // colour indices run from 0 to 63. Background pixels from a tile that's drawn over
+    // sprites also carry that above the tag, until the sprites have been drawn
+    constexpr u8 CGB_OBJECT_PALETTES = 8;
+    constexpr u8 CGB_PRIORITY_BIT    = 6;
+
+    /**
+     * @brief Tags a colour index with the palette it goes through
+     * 
+     * @param colour The raw colour index
+     * 
+     * @param palette The palette to tag it with
+     * @return The tagged colour index
+     */
+    constexpr auto tag(GBColour colour, PaletteID palette) -> GBColour
+    {
+        return static_cast<GBColour>(colour | (static_cast<u8>(palette) << PALETTE_SHIFT));
+    }
+
+    /**
+     * @brief Tags a colour index with the CGB palette it goes through
+     * 
+     * @param colour The raw colour index
+     * 
+     * @param palette The palette, 0-7 for the background and 8-15 for objects
+     * @return The tagged colour index
+     */
+    constexpr auto tag(GBColour colour, u8 palette) -> GBColour
+    {
+        return static_cast<GBColour>(colour | (palette << PALETTE_SHIFT));
+    }
+
+    /**
+     * @brief Converts a colour from CGB palette ram to a screen colour
+     * 
+     * @param colour The colour, as 5 bits each of red, green and blue from the lowest bit up
+     * @return The screen colour
+     */
+    constexpr auto fromRGB555(u16 colour) -> ScreenColour
+    {
+        // Copy the top bits into the bottom, so 0x1F comes out as 0xFF
+        auto expand = [](u16 channel) -> u8
+        {
+            channel &= 0x1F;
+            return static_cast<u8>((channel << 3) | (channel >> 2));
+        };
+
+        return { expand(colour), expand(colour >> 5), expand(colour >> 10), 0xFF };
+    }
+}
+
+namespace Tile
+{
+    /**
+     * @brief Builds a table spreading the 8 bits of a bitplane into
+     * the low bit of 8 bytes, one byte per pixel
+     * 
+     * @param flip Whether the leftmost pixel comes from bit 0 instead of bit 7
+     * @return The table, indexed by the bitplane
+     */
+    constexpr auto makeRowTable(bool flip) -> std::array<u64, 256>
+    {
+        std::array<u64, 256> table {};
+        for(u32 bits = 0; bits < table.size(); ++bits)
+        {
+            for(u32 pixel = 0; pixel < TILE_WIDTH; ++pixel)
+            {
+                u32 bit = flip ? pixel : TILE_WIDTH - 1 - pixel;
+
+                // The leftmost pixel lands in the first byte in memory
+                #ifdef IS_LITTLE_ENDIAN
+                    u32 byte = pixel;
+                #else
+                    u32 byte = TILE_WIDTH - 1 - pixel;
+                #endif
+
+                table[bits] |= static_cast<u64>((bits >> bit) & 1) << (byte * CHAR_BIT);
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<u64, 256> ROW_TABLE         = makeRowTable(false);
+    constexpr std::array<u64, 256> ROW_TABLE_FLIPPED = makeRowTable(true);
+
+    /**
+     * @brief Get the index of a tile from the start of VRAM
+     * 
+     * @param tileID The tile index read from a tile map
+     * 
+     * @param unsignedTiles Whether the tiles are addressed unsigned from 0x8000,
+     * or signed from 0x9000
+     * @return The tile's index from the start of VRAM (0-383)
+     */
+    [[nodiscard]] __always_inline auto getIndex(u8 tileID, bool unsignedTiles) -> u16
+    {
+        // if we're using tile data one we need treat the offset as signed from 128
+        return unsignedTiles
+             ? (TILE_DATA_HIGH - VRAM_START_ADDR) / BYTES_PER_TILE + (tileID                                   )
+             : (TILE_DATA_LOW  - VRAM_START_ADDR) / BYTES_PER_TILE + (static_cast<i8>(tileID) + TILE_ONE_OFFSET);
+    }
+
+    /**
+     * @brief Decodes a 2bpp tile row into 8 colour indices
+     * 
+     * @param row The two bitplane bytes of the row
+     * 
+     * @param flip Whether to mirror the row horizontally
+     * @return 8 colour indices, ready to be copied to memory in pixel order
+     */
+    [[nodiscard]] __always_inline auto decodeRow(const u8* row, bool flip = false) -> u64
+    {
+        const std::array<u64, 256>& table = flip ? ROW_TABLE_FLIPPED : ROW_TABLE;
+        return table[row[0]] | (table[row[1]] << 1);
+    }
 }
 
 
@@ -0,0 +1,73 @@
+#include "core.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "video/frame_hash.hpp"
+
+/**
+    Compares a stream of frame hashes written with --hash-frames against
+    a golden one, and reports the first frame where they differ.
+
+    Either stream can be binary or CSV. Frames are matched up by number,
+    so both runs need to have hashed the same frames, and a run that
+    stopped early or went on longer counts as differing at the first
+    frame only one of them has.
+
+    Usage: HashCompare <golden> <run>
+    Exits with 0 if every frame matches, 1 if they differ, or 2 if a
+    stream couldn't be read.
+**/
+
+auto main(int argc, char** argv) -> int
+{
+    if(argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <golden> <run>" << std::endl;
+        return 2;
+    }
+
+    std::optional<std::vector<FrameHash::Record>> golden = FrameHash::readStream(argv[1]);
+    std::optional<std::vector<FrameHash::Record>> run    = FrameHash::readStream(argv[2]);
+    if(!golden || !run)
+    {
+        std::cerr << "Could not read '" << (golden ? argv[2] : argv[1]) << "'!" << std::endl;
+        return 2;
+    }
+
+    auto hex = [](u64 hash) { std::stringstream ss; ss << std::hex << std::setw(16) << std::setfill('0') << hash; return ss.str(); };
+
+    size_t frames = std::min(golden->size(), run->size());
+    for(size_t i = 0; i < frames; ++i)
+    {
+        const FrameHash::Record& expected = (*golden)[i];
+        const FrameHash::Record& actual   = (*run)[i];
+
+        if(expected.frame != actual.frame)
+        {
+            std::cout << "Frame " << std::min(expected.frame, actual.frame) << " is only in the "
+                      << (expected.frame < actual.frame ? "golden stream" : "run") << std::endl;
+            return 1;
+        }
+
+        if(expected.hash != actual.hash)
+        {
+            std::cout << "First divergence at frame " << expected.frame << ": expected "
+                      << hex(expected.hash) << ", got " << hex(actual.hash) << std::endl;
+            return 1;
+        }
+    }
+
+    if(golden->size() != run->size())
+    {
+        const std::vector<FrameHash::Record>& longer = golden->size() > run->size() ? *golden : *run;
+        std::cout << "Frame " << longer[frames].frame << " is only in the "
+                  << (golden->size() > run->size() ? "golden stream" : "run") << std::endl;
+        return 1;
+    }
+
+    std::cout << "All " << frames << " frames match" << std::endl;
+    return 0;
+}